@@ -0,0 +1,325 @@
+#ifndef CONCURRENT_HASH_MAP
+#define CONCURRENT_HASH_MAP
+
+#include "HashMap.hpp"
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief A thread-safe hash map with striped locking
+ *
+ * Partitions the key space across a power-of-two
+ * number of stripes, each a @HashMap guarded by its
+ * own mutex, so operations on different stripes
+ * proceed in parallel. Rehashing happens per stripe
+ * under that stripe's lock only — there is no
+ * global stop-the-world.
+ *
+ * Values are returned by copy; handing out
+ * references into a stripe would race with
+ * concurrent rehashes.
+ */
+template <typename K, typename V>
+class ConcurrentHashMap {
+public:
+    ConcurrentHashMap(std::size_t numStripes = 16,
+                      std::size_t capacityPerStripe = 16,
+                      float loadFactor = 0.75):
+                                        m_numStripes(roundUpPow2(numStripes))
+    {
+        m_stripes = new Stripe[m_numStripes];
+        for(std::size_t i = 0;i<m_numStripes;i++) {
+            m_stripes[i].map = HashMap<K, V>(capacityPerStripe, loadFactor);
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap &operator=(const ConcurrentHashMap&) = delete;
+
+    ~ConcurrentHashMap() {
+        delete [] m_stripes;
+    }
+
+    void put(const K &k, V v) {
+        Stripe &s = stripeFor(k);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.map[k] = std::move(v);
+    }
+
+    // copies the value for the key into out;
+    // returns whether the key was present
+    bool tryGet(const K &k, V &out) {
+        Stripe &s = stripeFor(k);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        V *v = s.map.find(k);
+        if(!v) {
+            return false;
+        }
+        out = *v;
+        return true;
+    }
+
+    bool contains(const K &k) {
+        Stripe &s = stripeFor(k);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.map.contains(k);
+    }
+
+    bool erase(const K &k) {
+        Stripe &s = stripeFor(k);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.map.erase(k);
+    }
+
+    std::size_t size() {
+        std::size_t n = 0;
+        for(std::size_t i = 0;i<m_numStripes;i++) {
+            std::lock_guard<std::mutex> lock(m_stripes[i].mutex);
+            n += m_stripes[i].map.size();
+        }
+        return n;
+    }
+
+    std::size_t stripes() const {
+        return m_numStripes;
+    }
+
+private:
+    struct Stripe {
+        std::mutex mutex;
+        HashMap<K, V> map;
+    };
+
+    Stripe &stripeFor(const K &k) {
+        // the stripe comes from middle hash bits; the
+        // per-stripe map masks with the low bits, so
+        // reusing those would leave most of its
+        // buckets empty
+        std::size_t h = hash(k);
+        return m_stripes[(h>>16)&(m_numStripes-1)];
+    }
+
+private:
+    Stripe *m_stripes;
+    std::size_t m_numStripes;
+};
+
+/**
+ * @brief Hash map with a lock-free read path
+ *
+ * Built for read-mostly workloads (e.g. config
+ * maps updated a few times a second): readers
+ * walk bucket chains through release/acquire
+ * atomics without taking any lock, while writers
+ * serialize on a single mutex and never modify a
+ * published node in place — updates and erases
+ * unlink nodes and retire them to an epoch-based
+ * limbo list that is freed once no reader from
+ * that epoch remains.
+ *
+ * The bucket count is fixed at construction;
+ * size the table for the expected key set.
+ */
+template <typename K, typename V>
+class ReadMostlyHashMap {
+public:
+    ReadMostlyHashMap(std::size_t capacity = 256):
+                                        m_numBuckets(roundUpPow2(capacity)),
+                                        m_mask(roundUpPow2(capacity)-1),
+                                        m_epoch(0),
+                                        m_size(0)
+    {
+        m_buckets = new std::atomic<Node*>[m_numBuckets];
+        for(std::size_t i = 0;i<m_numBuckets;i++) {
+            m_buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+        m_readers[0].store(0);
+        m_readers[1].store(0);
+        m_limbo[0] = nullptr;
+        m_limbo[1] = nullptr;
+    }
+
+    ReadMostlyHashMap(const ReadMostlyHashMap&) = delete;
+    ReadMostlyHashMap &operator=(const ReadMostlyHashMap&) = delete;
+
+    ~ReadMostlyHashMap() {
+        for(std::size_t i = 0;i<m_numBuckets;i++) {
+            Node *n = m_buckets[i].load(std::memory_order_relaxed);
+            while(n) {
+                Node *tmp = n->next.load(std::memory_order_relaxed);
+                delete n;
+                n = tmp;
+            }
+        }
+        delete [] m_buckets;
+        freeLimbo(0);
+        freeLimbo(1);
+    }
+
+    // lock-free; copies the value into out and
+    // returns whether the key was present
+    bool tryGet(const K &k, V &out) {
+        std::size_t h = hash(k);
+        int e = enterEpoch();
+        bool found = false;
+        Node *n = m_buckets[h&m_mask].load(std::memory_order_acquire);
+        while(n) {
+            if(n->kv.hash == h && n->kv.key == k) {
+                out = n->kv.value;
+                found = true;
+                break;
+            }
+            n = n->next.load(std::memory_order_acquire);
+        }
+        exitEpoch(e);
+        return found;
+    }
+
+    bool contains(const K &k) {
+        std::size_t h = hash(k);
+        int e = enterEpoch();
+        bool found = false;
+        Node *n = m_buckets[h&m_mask].load(std::memory_order_acquire);
+        while(n) {
+            if(n->kv.hash == h && n->kv.key == k) {
+                found = true;
+                break;
+            }
+            n = n->next.load(std::memory_order_acquire);
+        }
+        exitEpoch(e);
+        return found;
+    }
+
+    // inserts or replaces; published nodes are never
+    // modified in place, an update links a fresh node
+    // and retires the old one
+    void put(const K &k, V v) {
+        std::size_t h = hash(k);
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        Node *fresh = new Node(KeyVal<K, V>(k, std::move(v), h));
+        auto &head = m_buckets[h&m_mask];
+        fresh->next.store(head.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+        head.store(fresh, std::memory_order_release);
+
+        // unlink a previous node for the key, if any
+        Node *prev = fresh;
+        Node *n = fresh->next.load(std::memory_order_relaxed);
+        while(n) {
+            Node *next = n->next.load(std::memory_order_relaxed);
+            if(n->kv.hash == h && n->kv.key == k) {
+                prev->next.store(next, std::memory_order_release);
+                retire(n);
+                tryReclaim();
+                return;
+            }
+            prev = n;
+            n = next;
+        }
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        tryReclaim();
+    }
+
+    bool erase(const K &k) {
+        std::size_t h = hash(k);
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        auto &head = m_buckets[h&m_mask];
+        Node *prev = nullptr;
+        Node *n = head.load(std::memory_order_relaxed);
+        while(n) {
+            Node *next = n->next.load(std::memory_order_relaxed);
+            if(n->kv.hash == h && n->kv.key == k) {
+                if(prev) {
+                    prev->next.store(next, std::memory_order_release);
+                } else {
+                    head.store(next, std::memory_order_release);
+                }
+                retire(n);
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                tryReclaim();
+                return true;
+            }
+            prev = n;
+            n = next;
+        }
+        return false;
+    }
+
+    std::size_t size() const {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Node {
+        Node(KeyVal<K, V> v): kv(std::move(v)),
+                              next(nullptr),
+                              nextLimbo(nullptr)
+        {}
+        KeyVal<K, V> kv;
+        std::atomic<Node*> next;
+        Node *nextLimbo;
+    };
+
+    int enterEpoch() {
+        for(;;) {
+            int e = m_epoch.load(std::memory_order_acquire);
+            m_readers[e].fetch_add(1, std::memory_order_acq_rel);
+            // re-check: the epoch may have flipped between
+            // the load and the increment
+            if(m_epoch.load(std::memory_order_acquire) == e) {
+                return e;
+            }
+            m_readers[e].fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void exitEpoch(int e) {
+        m_readers[e].fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // called under the write mutex
+    void retire(Node *n) {
+        int e = m_epoch.load(std::memory_order_relaxed);
+        n->nextLimbo = m_limbo[e];
+        m_limbo[e] = n;
+    }
+
+    // called under the write mutex. Flips the epoch
+    // when the other side has no readers left; nodes
+    // retired into that side were unlinked at least
+    // one full epoch ago, so nobody can hold them
+    void tryReclaim() {
+        int e = m_epoch.load(std::memory_order_relaxed);
+        int other = 1-e;
+        if(m_readers[other].load(std::memory_order_acquire) == 0) {
+            freeLimbo(other);
+            m_epoch.store(other, std::memory_order_release);
+        }
+    }
+
+    void freeLimbo(int e) {
+        Node *n = m_limbo[e];
+        while(n) {
+            Node *tmp = n->nextLimbo;
+            delete n;
+            n = tmp;
+        }
+        m_limbo[e] = nullptr;
+    }
+
+private:
+    std::atomic<Node*> *m_buckets;
+    std::size_t m_numBuckets;
+    std::size_t m_mask;
+    std::mutex m_writeMutex;
+    std::atomic<int> m_epoch;
+    std::atomic<std::size_t> m_readers[2];
+    Node *m_limbo[2];
+    std::atomic<std::size_t> m_size;
+};
+
+#endif // CONCURRENT_HASH_MAP
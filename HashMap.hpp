@@ -2,110 +2,340 @@
 #define HASH_MAP
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <cassert>
+#include <new>
 #include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
-template <typename T>
-struct ListItem {
-    ListItem(const T &v, ListItem<T> *p = nullptr, 
-                      ListItem<T> *n = nullptr): 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// recency links threaded through every node of a
+// capacity-capped @LruHashMap. The default variant is
+// empty so the nodes (and the inline first entry of
+// every bucket) of an unbounded map pay no size cost
+template <typename Node, bool Lru>
+struct LruLinks {
+};
+
+template <typename Node>
+struct LruLinks<Node, true> {
+    LruLinks(): lruPrev(nullptr),
+                lruNext(nullptr)
+    {}
+    Node *lruPrev;
+    Node *lruNext;
+};
+
+template <typename T, bool Lru = false>
+struct ListItem: LruLinks<ListItem<T, Lru>, Lru> {
+    ListItem(): value(),
+                prev(nullptr),
+                next(nullptr)
+    {}
+    ListItem(const T &v, ListItem<T, Lru> *p = nullptr,
+                      ListItem<T, Lru> *n = nullptr):
                                         value(v),
                                         prev(p),
                                         next(n)
     {}
-    ListItem<T> *prev;
-    ListItem<T> *next;
+    ListItem(T &&v, ListItem<T, Lru> *p = nullptr,
+                      ListItem<T, Lru> *n = nullptr):
+                                        value(std::move(v)),
+                                        prev(p),
+                                        next(n)
+    {}
+    ListItem<T, Lru> *prev;
+    ListItem<T, Lru> *next;
     T value;
 };
 
+
+/**
+ * @brief Slab arena for list nodes
+ *
+ * Hands out fixed-size nodes carved from
+ * large contiguous slabs with a bump
+ * pointer. Freed nodes go to a free list
+ * for reuse and releaseAll() returns whole
+ * slabs at once, so tearing down a large
+ * map is a few frees instead of one free
+ * per node.
+ */
 template <typename T>
+class NodeArena {
+public:
+    NodeArena(std::size_t nodesPerSlab = 1024): m_slabs(nullptr),
+                                                m_freeList(nullptr),
+                                                m_nodesPerSlab(nodesPerSlab),
+                                                m_slabUsed(nodesPerSlab)
+    {}
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena &operator=(const NodeArena&) = delete;
+
+    NodeArena(NodeArena &&other): m_slabs(other.m_slabs),
+                                  m_freeList(other.m_freeList),
+                                  m_nodesPerSlab(other.m_nodesPerSlab),
+                                  m_slabUsed(other.m_slabUsed)
+    {
+        other.m_slabs = nullptr;
+        other.m_freeList = nullptr;
+        other.m_slabUsed = other.m_nodesPerSlab;
+    }
+
+    NodeArena &operator=(NodeArena &&other) {
+        if(this != &other) {
+            releaseAll();
+            m_slabs = other.m_slabs;
+            m_freeList = other.m_freeList;
+            m_nodesPerSlab = other.m_nodesPerSlab;
+            m_slabUsed = other.m_slabUsed;
+            other.m_slabs = nullptr;
+            other.m_freeList = nullptr;
+            other.m_slabUsed = other.m_nodesPerSlab;
+        }
+        return *this;
+    }
+
+    ~NodeArena() {
+        releaseAll();
+    }
+
+    void *allocate() {
+        if(m_freeList) {
+            FreeNode *n = m_freeList;
+            m_freeList = n->next;
+            return n;
+        }
+        if(m_slabUsed == m_nodesPerSlab) {
+            Slab *s = static_cast<Slab*>(::operator new(
+                    Slab::headerSize() + m_nodesPerSlab*sizeof(T)));
+            s->next = m_slabs;
+            m_slabs = s;
+            m_slabUsed = 0;
+        }
+        return m_slabs->storage() + m_slabUsed++ * sizeof(T);
+    }
+
+    // returns node storage to the free list;
+    // the caller must have destroyed the object
+    void deallocate(void *p) {
+        FreeNode *n = static_cast<FreeNode*>(p);
+        n->next = m_freeList;
+        m_freeList = n;
+    }
+
+    // drops all slabs at once; every node handed
+    // out by this arena becomes invalid
+    void releaseAll() {
+        Slab *s = m_slabs;
+        while(s) {
+            Slab *tmp = s->next;
+            ::operator delete(s);
+            s = tmp;
+        }
+        m_slabs = nullptr;
+        m_freeList = nullptr;
+        m_slabUsed = m_nodesPerSlab;
+    }
+
+private:
+    // ::operator new aligns the slab to max_align_t only,
+    // so the arena cannot serve types aligned past that
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "NodeArena cannot hold over-aligned node types");
+
+    struct Slab {
+        Slab *next;
+
+        // node storage starts at the next alignof(T)
+        // boundary past the header, keeping over-aligned
+        // value types as aligned as per-node new would
+        static std::size_t headerSize() {
+            return (sizeof(Slab)+alignof(T)-1) & ~(alignof(T)-1);
+        }
+
+        char *storage() {
+            return reinterpret_cast<char*>(this) + headerSize();
+        }
+    };
+
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    Slab *m_slabs;
+    FreeNode *m_freeList;
+    std::size_t m_nodesPerSlab;
+    std::size_t m_slabUsed;
+};
+
+/**
+ * @brief Doubly-linked list with an inline first node
+ *
+ * The first element is embedded in the list object
+ * itself rather than heap-allocated; only overflow
+ * elements get chained through arena nodes. Used as
+ * the bucket type of @BucketPool, this puts the
+ * first key of every bucket in the bucket array, so
+ * the common one-entry probe resolves within the
+ * cache line the bucket index already fetched.
+ */
+template <typename T, bool Lru = false>
 class LinkedList {
 public:
 
     LinkedList(): m_tail(nullptr),
-                  m_head(nullptr)
+                  m_head(nullptr),
+                  m_size(0),
+                  m_arena(nullptr)
     {}
     
     // performs a deep copy of whole list
-    LinkedList(const LinkedList<T> &other) {
-        m_head = m_tail = nullptr;
-        ListItem<T> *i = other.m_head;
-        ListItem<T> *prev = nullptr;
-        while(i) {
-            ListItem<T> *j = new ListItem<T>(i->value);
-            if(!m_head) {
-                m_head = j;
-            }
-            if(prev) {
-                prev->next = j;
-            }
-            j->prev = prev;
-            m_tail = prev = j;
-            i = i->next;
+    LinkedList(const LinkedList<T, Lru> &other): m_tail(nullptr),
+                                            m_head(nullptr),
+                                            m_size(0),
+                                            m_arena(other.m_arena)
+    {
+        for(ListItem<T, Lru> *i = other.m_head; i; i = i->next) {
+            pushBack(i->value);
+        }
+    }
+
+    LinkedList(LinkedList<T, Lru> &&other): m_tail(nullptr),
+                                       m_head(nullptr),
+                                       m_size(0),
+                                       m_arena(other.m_arena)
+    {
+        adopt(std::move(other));
+    }
+
+    LinkedList<T, Lru> &operator=(const LinkedList<T, Lru> &other) {
+        if(this != &other) {
+            LinkedList<T, Lru> copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    LinkedList<T, Lru> &operator=(LinkedList<T, Lru> &&other) {
+        if(this != &other) {
+            clear();
+            m_arena = other.m_arena;
+            adopt(std::move(other));
         }
+        return *this;
     }
 
     ~LinkedList() {
         clear();
     }
 
-    void clear() {
-        if(!m_head) {
-            return;
-        }
+    // all nodes are allocated from the arena;
+    // must be set before the first pushBack()
+    void setArena(NodeArena<ListItem<T, Lru>> *arena) {
+        m_arena = arena;
+    }
 
-        ListItem<T> *i = m_head;
-        ListItem<T> *tmp = nullptr;
+    void clear() {
+        ListItem<T, Lru> *i = m_first.next;
         while(i) {
-            tmp = i->next;
-            delete i;
+            ListItem<T, Lru> *tmp = i->next;
+            freeItem(i);
             i = tmp;
         }
+        if(m_size) {
+            m_first.value = T();
+        }
+        m_first.next = nullptr;
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+    // forgets all overflow nodes without freeing them;
+    // used for bulk teardown when the owning
+    // arena releases the slabs as a whole
+    void reset() {
+        m_first.next = nullptr;
         m_head = nullptr;
         m_tail = nullptr;
+        m_size = 0;
     }
 
     std::size_t size() const {
-        if(!m_head) {
-            return 0;
-        }
-        std::size_t n = 0;
-        ListItem<T> *i = m_head;
-        do {
-            n++;
-        } while((i = i->next));
-        return n;
+        return m_size;
     }
 
     void pushBack(const T &val) {
-        if(!m_head) {
-            m_head = new ListItem<T>(val);
-            m_tail = m_head;
-        } else {
-            m_tail->next = new ListItem<T>(val);  
-            m_tail->next->prev = m_tail;
-            m_tail = m_tail->next;
+        if(!m_size) {
+            m_first.value = val;
+            linkFirst();
+            return;
+        }
+        linkBack(allocItem(val));
+    }
+
+    void pushBack(T &&val) {
+        if(!m_size) {
+            m_first.value = std::move(val);
+            linkFirst();
+            return;
         }
+        linkBack(allocItem(std::move(val)));
     }
     
-    void remove(ListItem<T> *i) {
+    void remove(ListItem<T, Lru> *i) {
         if(!i) {
             return;
         }
-        ListItem<T> *prev = i->prev;
-        ListItem<T> *next = i->next;
+        if(i == &m_first) {
+            ListItem<T, Lru> *n = m_first.next;
+            if(n) {
+                // promote the first overflow node into
+                // the inline slot
+                m_first.value = std::move(n->value);
+                m_first.next = n->next;
+                if(n->next) {
+                    n->next->prev = &m_first;
+                }
+                if(m_tail == n) {
+                    m_tail = &m_first;
+                }
+                freeItem(n);
+            } else {
+                m_first.value = T();
+                m_head = nullptr;
+                m_tail = nullptr;
+            }
+            m_size--;
+            return;
+        }
+        ListItem<T, Lru> *prev = i->prev;
+        ListItem<T, Lru> *next = i->next;
         if(prev) {
             prev->next = next;
         }
         if(next) {
             next->prev = prev;
         }
-        delete i;
+        if(i == m_tail) {
+            m_tail = prev;
+        }
+        freeItem(i);
+        m_size--;
     }
 
     T &get(std::size_t n) const {
-        ListItem<T> *i = m_head;
+        ListItem<T, Lru> *i = m_head;
         while(i) {
             if(!n--) {
                 return i->value;
@@ -123,15 +353,87 @@ public:
         return m_tail->value;
     }
 
+    ListItem<T, Lru> *tailItem() const {
+        return m_tail;
+    }
+
+    ListItem<T, Lru> *head() const {
+        return m_head;
+    }
+
+private:
+    void linkFirst() {
+        m_first.next = nullptr;
+        m_first.prev = nullptr;
+        m_head = &m_first;
+        m_tail = &m_first;
+        m_size = 1;
+    }
+
+    void linkBack(ListItem<T, Lru> *i) {
+        m_tail->next = i;
+        i->prev = m_tail;
+        m_tail = i;
+        m_size++;
+    }
+
+    // takes over other's elements; the inline first
+    // entry lives inside the list object, so it moves
+    // by value and the overflow chain is re-anchored
+    void adopt(LinkedList<T, Lru> &&other) {
+        if(!other.m_size) {
+            return;
+        }
+        m_first.value = std::move(other.m_first.value);
+        m_first.next = other.m_first.next;
+        m_first.prev = nullptr;
+        if(m_first.next) {
+            m_first.next->prev = &m_first;
+        }
+        m_head = &m_first;
+        m_tail = (other.m_tail == &other.m_first) ? &m_first : other.m_tail;
+        m_size = other.m_size;
+        other.reset();
+    }
+
+    ListItem<T, Lru> *allocItem(const T &val) {
+        if(m_arena) {
+            return new(m_arena->allocate()) ListItem<T, Lru>(val);
+        }
+        return new ListItem<T, Lru>(val);
+    }
+
+    ListItem<T, Lru> *allocItem(T &&val) {
+        if(m_arena) {
+            return new(m_arena->allocate()) ListItem<T, Lru>(std::move(val));
+        }
+        return new ListItem<T, Lru>(std::move(val));
+    }
+
+    void freeItem(ListItem<T, Lru> *i) {
+        if(m_arena) {
+            i->~ListItem<T, Lru>();
+            m_arena->deallocate(i);
+        } else {
+            delete i;
+        }
+    }
+
 private:
-    ListItem<T> *m_head;
-    ListItem<T> *m_tail;
+    ListItem<T, Lru> *m_head;
+    ListItem<T, Lru> *m_tail;
+    std::size_t m_size;
+    NodeArena<ListItem<T, Lru>> *m_arena;
+    ListItem<T, Lru> m_first;
 
 };
 
 template <typename K, typename V>
 struct KeyVal {
-    KeyVal(K k = K{}, const V v = V{}): key(k), value(v)
+    KeyVal(K k = K{}, V v = V{}, std::size_t h = 0):
+                                        key(std::move(k)),
+                                        value(std::move(v)),
+                                        hash(h)
     {}
 
     std::ostream &write(std::ostream &s) const {
@@ -140,6 +442,10 @@ struct KeyVal {
 
     K key;
     V value;
+    // cached hash of key; lets rehashing re-bucket
+    // without recomputing and lets probes reject
+    // mismatches with one integer compare
+    std::size_t hash;
 };
 
 template <typename K, typename V>
@@ -147,14 +453,76 @@ std::ostream &operator<<(std::ostream &s, const KeyVal<K, V> &kv) {
     kv.write(s);
 }
 
-template <typename K, typename V>
+// hints the prefetcher at memory a probe is about
+// to touch; compiles to nothing where unsupported
+inline void prefetchRead(const void *p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p, 0);
+#else
+    (void)p;
+#endif
+}
+
+// rounds up to the next power of two so bucket
+// indexing can be a mask instead of a division
+inline std::size_t roundUpPow2(std::size_t n) {
+    std::size_t p = 1;
+    while(p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+template <typename K, typename V, bool Lru = false>
 class BucketPool {
 public:
-    BucketPool(std::size_t size): m_pool(nullptr), m_poolSize(0)
+    BucketPool(std::size_t size): m_pool(nullptr),
+                                  m_poolSize(0),
+                                  m_mask(0),
+                                  m_adopted(nullptr)
     {
         resize(size);
     }
 
+    BucketPool(const BucketPool&) = delete;
+    BucketPool &operator=(const BucketPool&) = delete;
+
+    BucketPool(BucketPool &&other): m_pool(other.m_pool),
+                                    m_poolSize(other.m_poolSize),
+                                    m_mask(other.m_mask),
+                                    m_arena(std::move(other.m_arena)),
+                                    m_adopted(other.m_adopted)
+    {
+        other.m_adopted = nullptr;
+        other.m_pool = nullptr;
+        other.m_poolSize = 0;
+        other.m_mask = 0;
+        // the lists point at the arena of the source
+        // pool; retarget them at ours
+        for(std::size_t i = 0;i<m_poolSize;i++) {
+            m_pool[i].setArena(&m_arena);
+        }
+    }
+
+    BucketPool &operator=(BucketPool &&other) {
+        if(this != &other) {
+            clear();
+            m_pool = other.m_pool;
+            m_poolSize = other.m_poolSize;
+            m_mask = other.m_mask;
+            m_arena = std::move(other.m_arena);
+            m_adopted = other.m_adopted;
+            other.m_adopted = nullptr;
+            other.m_pool = nullptr;
+            other.m_poolSize = 0;
+            other.m_mask = 0;
+            for(std::size_t i = 0;i<m_poolSize;i++) {
+                m_pool[i].setArena(&m_arena);
+            }
+        }
+        return *this;
+    }
+
     ~BucketPool() {
         clear();
     }
@@ -164,46 +532,96 @@ public:
             return;
         }
 
+        for(std::size_t i = 0;i<m_poolSize;i++) {
+            m_pool[i].reset();
+        }
         delete [] m_pool;
+        m_arena.releaseAll();
+        while(m_adopted) {
+            AdoptedArena *tmp = m_adopted->next;
+            delete m_adopted;
+            m_adopted = tmp;
+        }
         m_pool = nullptr;
         m_poolSize = 0;
     }
 
+    // points the lists in [lo, hi) at a caller-owned
+    // arena (nullptr restores the pool's own); lets a
+    // parallel-build worker allocate overflow nodes
+    // for its bucket slice without contention
+    void setRangeArena(std::size_t lo, std::size_t hi,
+                       NodeArena<ListItem<KeyVal<K, V>, Lru>> *arena) {
+        for(std::size_t i = lo;i<hi;i++) {
+            m_pool[i].setArena(arena ? arena : &m_arena);
+        }
+    }
+
+    // takes ownership of an arena whose nodes are
+    // already linked into this pool's lists, keeping
+    // the slabs alive until the pool is cleared
+    void adoptArena(NodeArena<ListItem<KeyVal<K, V>, Lru>> &&arena) {
+        m_adopted = new AdoptedArena(std::move(arena), m_adopted);
+    }
+
 
-    LinkedList<KeyVal<K, V>> &get(std::size_t n) const {
+    LinkedList<KeyVal<K, V>, Lru> &get(std::size_t n) const {
         assert(m_pool);
         assert(n<m_poolSize);
         return m_pool[n];
     }
 
-    LinkedList<KeyVal<K, V>> &operator[](std::size_t n) const {
+    LinkedList<KeyVal<K, V>, Lru> &operator[](std::size_t n) const {
         return get(n);
     }
 
     void resize(std::size_t newSize) {
+        newSize = roundUpPow2(newSize);
         if(!m_pool) {
-            m_pool = new LinkedList<KeyVal<K, V>>[newSize];
+            m_pool = new LinkedList<KeyVal<K, V>, Lru>[newSize];
             m_poolSize = newSize;
         } else {
-            LinkedList<KeyVal<K, V>> *newPool = new LinkedList<KeyVal<K, V>>[newSize];
+            LinkedList<KeyVal<K, V>, Lru> *newPool = new LinkedList<KeyVal<K, V>, Lru>[newSize];
             if(newSize>m_poolSize) {
-                std::copy(m_pool, m_pool+m_poolSize, newPool);
+                std::move(m_pool, m_pool+m_poolSize, newPool);
             } else {
-                std::copy(m_pool, m_pool+newSize, newPool);
+                std::move(m_pool, m_pool+newSize, newPool);
             }
             delete [] m_pool;
             m_pool = newPool;
             m_poolSize = newSize;
         }
+        m_mask = m_poolSize-1;
+        for(std::size_t i = 0;i<m_poolSize;i++) {
+            m_pool[i].setArena(&m_arena);
+        }
     }
 
     std::size_t size() const {
         return m_poolSize;
     }
 
+    // size()-1; valid because the pool size is
+    // always a power of two
+    std::size_t mask() const {
+        return m_mask;
+    }
+
 private:
-    LinkedList<KeyVal<K, V>> *m_pool;
+    struct AdoptedArena {
+        AdoptedArena(NodeArena<ListItem<KeyVal<K, V>, Lru>> &&a,
+                     AdoptedArena *n): arena(std::move(a)),
+                                       next(n)
+        {}
+        NodeArena<ListItem<KeyVal<K, V>, Lru>> arena;
+        AdoptedArena *next;
+    };
+
+    LinkedList<KeyVal<K, V>, Lru> *m_pool;
     std::size_t m_poolSize;
+    std::size_t m_mask;
+    NodeArena<ListItem<KeyVal<K, V>, Lru>> m_arena;
+    AdoptedArena *m_adopted;
 };
 
 /**
@@ -217,208 +635,2015 @@ private:
 template <typename T> std::size_t hash(const T&);
 
 /**
- * @brief Hash function for std::string
+ * @brief Final avalanche for 64-bit hashes
  *
- * Uses djb2 hashing algorithm.
- * http://www.cse.yorku.ca/~oz/hash.html
+ * murmur3 finalizer; spreads entropy of the
+ * accumulated state across all output bits.
  */
-template <>
-std::size_t hash(const std::string &str) {
-    std::size_t h = 5328;
-
-    for(auto ch : str) {
-        h = ((h << 5) + h) + ch;
-    }
+inline std::uint64_t hashFinalize(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
     return h;
 }
 
 /**
- * @brief Hash function for std::int32_t
+ * @brief Hash function over a byte range
  *
- * Uses multiplication method;
- * http://lcm.csa.iisc.ernet.in/dsa/node44.html
+ * Consumes 16 bytes per iteration — with an
+ * SSE2 block kernel where available and a
+ * portable 64-bit scalar loop otherwise —
+ * instead of the previous byte-at-a-time
+ * djb2 loop, which dominated lookup cost
+ * on long (URL-sized) keys. Shared by the
+ * std::string, @StringRef and C-string
+ * overloads so they all hash identically.
  */
+inline std::size_t hashBytes(const char *p, std::size_t len) {
+    std::uint64_t h = 0xcbf29ce484222325ull ^ len;
+
+#if defined(__SSE2__)
+    if(len >= 16) {
+        __m128i acc = _mm_set1_epi64x(h);
+        do {
+            __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(p));
+            acc = _mm_xor_si128(acc, v);
+            // swap the 64-bit lanes and add so the
+            // lanes keep feeding into each other
+            acc = _mm_add_epi64(acc, _mm_shuffle_epi32(acc, 0x4e));
+            p += 16;
+            len -= 16;
+        } while(len >= 16);
+        std::uint64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        h = (lanes[0] ^ (lanes[1] >> 31)) * 0x9e3779b97f4a7c15ull;
+    }
+#else
+    while(len >= 16) {
+        std::uint64_t a, b;
+        std::memcpy(&a, p, 8);
+        std::memcpy(&b, p+8, 8);
+        h = (h ^ a) * 0x9e3779b97f4a7c15ull;
+        h = (h ^ b) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+        p += 16;
+        len -= 16;
+    }
+#endif
+
+    while(len >= 8) {
+        std::uint64_t a;
+        std::memcpy(&a, p, 8);
+        h = (h ^ a) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 32;
+        p += 8;
+        len -= 8;
+    }
+
+    if(len) {
+        std::uint64_t a = 0;
+        std::memcpy(&a, p, len);
+        h = (h ^ a) * 0x9e3779b97f4a7c15ull;
+    }
+
+    return std::size_t(hashFinalize(h));
+}
+
 template <>
-std::size_t hash(const std::int32_t &n) {
-    static const double goldenRatio = 0.6180339887;
-    double fractionPart = n*goldenRatio - std::size_t(n*goldenRatio);
-    return std::size_t(fractionPart*(2 << 30));
+std::size_t hash(const std::string &str) {
+    return hashBytes(str.data(), str.size());
 }
 
 /**
- * @brief Hash function for std::uint32_t
+ * @brief Hash functions for integer types
  *
- * Uses multiplication method;
- * http://lcm.csa.iisc.ernet.in/dsa/node44.html
+ * Use the murmur3 avalanche over the widened
+ * value. The previous golden-ratio variant went
+ * through double arithmetic and capped its output
+ * at 2<<30, leaving the upper bits always zero —
+ * which aliases badly once the table grows large.
  */
+template <>
+std::size_t hash(const std::int32_t &n) {
+    return std::size_t(hashFinalize(std::uint64_t(std::uint32_t(n))));
+}
+
 template <>
 std::size_t hash(const std::uint32_t &n) {
-    static const double goldenRatio = 0.6180339887;
-    double fractionPart = n*goldenRatio - std::size_t(n*goldenRatio);
-    return std::size_t(fractionPart*(2 << 30));
+    return std::size_t(hashFinalize(std::uint64_t(n)));
 }
 
-enum HashMapIteratorPos {
-    HASH_MAP_BEGIN,
-    HASH_MAP_END
+template <>
+std::size_t hash(const std::int64_t &n) {
+    return std::size_t(hashFinalize(std::uint64_t(n)));
+}
+
+template <>
+std::size_t hash(const std::uint64_t &n) {
+    return std::size_t(hashFinalize(n));
+}
+
+/**
+ * @brief Hash function for pointer keys
+ *
+ * Shifts out the alignment zero bits before
+ * mixing so adjacent objects do not collide
+ * into neighbouring buckets.
+ */
+template <typename T>
+std::size_t hash(T * const &p) {
+    return std::size_t(hashFinalize(
+            reinterpret_cast<std::uintptr_t>(p) >> 3));
+}
+
+/**
+ * @brief A non-owning view of a character range
+ *
+ * Lets lookups into string-keyed maps probe
+ * straight off a parsed buffer: a StringRef
+ * hashes and compares equal to the std::string
+ * holding the same bytes, so no temporary key
+ * is ever materialized.
+ */
+struct StringRef {
+    StringRef(const char *s): data(s), size(std::strlen(s)) {}
+    StringRef(const char *s, std::size_t n): data(s), size(n) {}
+    StringRef(const std::string &s): data(s.data()), size(s.size()) {}
+
+    const char *data;
+    std::size_t size;
 };
 
-template <typename K, typename V>
-class HashMapIterator: public std::iterator<std::forward_iterator_tag, KeyVal<K, V>> {
-public:
+inline bool operator==(const std::string &a, const StringRef &b) {
+    return a.size() == b.size &&
+           std::memcmp(a.data(), b.data, b.size) == 0;
+}
 
-    explicit HashMapIterator(HashMapIteratorPos pos,
-                             const BucketPool<K, V> &pool):
-                                        m_pos(pos),
-                                        m_pool(pool),
-                                        m_curItem(-1)
-    {
-        if(pos == HASH_MAP_BEGIN) {
-            m_curBucket = 0;
-            m_curItem = 0;
-        } else {
-            m_curBucket = m_pool.size()-1;
-            std::size_t psz = m_pool[m_curBucket].size()-1;
-            m_curItem = psz?psz:-1;
-        }
-        findNextBucket();
-    }
+inline bool operator==(const StringRef &a, const std::string &b) {
+    return b == a;
+}
 
-    // pre-increment
-    HashMapIterator<K, V> &operator++() {
-        m_curItem++;
-        if(m_curItem>=m_pool[m_curBucket].size()) {
-            m_curBucket++;
-            m_curItem = 0;
-        }
+inline std::size_t hash(const StringRef &s) {
+    return hashBytes(s.data, s.size);
+}
 
-        findNextBucket();
-        return *this;
-    }
+// C-string keys hash their bytes; without this
+// overload the generic pointer hash above would
+// silently match and hash the address instead
+inline std::size_t hash(const char * const &s) {
+    return hashBytes(s, std::strlen(s));
+}
 
-    // post-increment
-    HashMapIterator<K, V> operator++(int) {
-        HashMapIterator itr(*this);
-        return itr;
-    }
+/**
+ * @brief Slot states for @OpenAddressPool
+ */
+enum SlotState {
+    SLOT_EMPTY,
+    SLOT_OCCUPIED,
+    SLOT_DELETED
+};
 
-    KeyVal<K, V> &operator*() const {
-        return m_pool[m_curBucket][m_curItem];
-    }
+/**
+ * @brief Flat open-addressing storage for @HashMap
+ *
+ * Stores entries directly in a contiguous
+ * array of slots and resolves collisions
+ * with linear probing, so a lookup touches
+ * one or two cache lines instead of
+ * walking a per-bucket linked list.
+ */
+template <typename K, typename V>
+class OpenAddressPool {
+public:
+    struct Slot {
+        Slot(): state(SLOT_EMPTY)
+        {}
+        KeyVal<K, V> kv;
+        SlotState state;
+    };
 
-    KeyVal<K, V> &operator->() const {
-        return operator*();
+    OpenAddressPool(std::size_t size): m_slots(nullptr),
+                                       m_numSlots(0),
+                                       m_mask(0),
+                                       m_numUsed(0),
+                                       m_numDeleted(0)
+    {
+        resize(size);
     }
 
-    bool operator==(const HashMapIterator &other) const {
-        return m_curBucket == other.m_curBucket &&
-               m_curItem == other.m_curItem;
-    }
+    OpenAddressPool(const OpenAddressPool&) = delete;
+    OpenAddressPool &operator=(const OpenAddressPool&) = delete;
 
-    bool operator!=(const HashMapIterator &other) const {
-        return !operator==(other);
+    OpenAddressPool(OpenAddressPool &&other): m_slots(other.m_slots),
+                                              m_numSlots(other.m_numSlots),
+                                              m_mask(other.m_mask),
+                                              m_numUsed(other.m_numUsed),
+                                              m_numDeleted(other.m_numDeleted)
+    {
+        other.m_slots = nullptr;
+        other.m_numSlots = 0;
+        other.m_mask = 0;
+        other.m_numUsed = 0;
+        other.m_numDeleted = 0;
     }
 
-private:
-    void findNextBucket() {
-        while(m_curBucket < m_pool.size() && !m_pool[m_curBucket].size()) {
-            m_curBucket++;
-            m_curItem = 0;
+    OpenAddressPool &operator=(OpenAddressPool &&other) {
+        if(this != &other) {
+            clear();
+            m_slots = other.m_slots;
+            m_numSlots = other.m_numSlots;
+            m_mask = other.m_mask;
+            m_numUsed = other.m_numUsed;
+            m_numDeleted = other.m_numDeleted;
+            other.m_slots = nullptr;
+            other.m_numSlots = 0;
+            other.m_mask = 0;
+            other.m_numUsed = 0;
+            other.m_numDeleted = 0;
         }
+        return *this;
     }
 
-private:
-    HashMapIteratorPos m_pos;
-    const BucketPool<K, V> &m_pool;
-    int m_curBucket;
-    int m_curItem;
-};
+    ~OpenAddressPool() {
+        clear();
+    }
 
-template <typename K, typename V>
-class HashMap {
-public:
-    HashMap( std::size_t capacity = 16, float loadFactor = 0.75): 
-                                        m_buckets(capacity),
-                                        m_loadFactor(loadFactor)
-    {}
+    void clear() {
+        if(!m_slots) {
+            return;
+        }
 
-    std::size_t capacity() const {
-        return m_buckets.size();
+        delete [] m_slots;
+        m_slots = nullptr;
+        m_numSlots = 0;
+        m_numUsed = 0;
+        m_numDeleted = 0;
     }
 
-    std::size_t size() {
-        std::size_t n = 0;
-        for(int i = 0;i<m_buckets.size();i++) {
-            n+=m_buckets[i].size();
+    // returns pointer to the value for given key
+    // or nullptr if the key is not present
+    template <typename LK>
+    V *find(std::size_t h, const LK &k) const {
+        assert(m_slots);
+        std::size_t i = h&m_mask;
+        for(std::size_t probe = 0;probe<m_numSlots;probe++) {
+            Slot &s = m_slots[i];
+            if(s.state == SLOT_EMPTY) {
+                return nullptr;
+            }
+            if(s.state == SLOT_OCCUPIED && s.kv.hash == h &&
+                    s.kv.key == k) {
+                return &s.kv.value;
+            }
+            i = (i+1)&m_mask;
         }
-        return n;
+        return nullptr;
     }
 
-    float getLoad() {
-        return (float)size()/capacity();
+    // inserts entry assuming the key is not present;
+    // caller is responsible for keeping the load below 1
+    V &insert(std::size_t h, KeyVal<K, V> kv) {
+        assert(m_slots);
+        assert(m_numUsed<m_numSlots);
+        std::size_t i = h&m_mask;
+        while(m_slots[i].state == SLOT_OCCUPIED) {
+            i = (i+1)&m_mask;
+        }
+        if(m_slots[i].state == SLOT_DELETED) {
+            m_numDeleted--;
+        }
+        m_slots[i].kv = std::move(kv);
+        m_slots[i].state = SLOT_OCCUPIED;
+        m_numUsed++;
+        return m_slots[i].kv.value;
     }
 
-    V &get(const K &k) {
-        std::size_t h = hash(k)%capacity();
-        auto &list = m_buckets[h];
-        for(int j = 0;j<list.size();j++) {
-            if(list[j].key == k) {
-                return list[j].value;
+    // marks the slot as deleted so later probes can
+    // skip over it; returns whether the key existed
+    template <typename LK>
+    bool erase(std::size_t h, const LK &k) {
+        assert(m_slots);
+        std::size_t i = h&m_mask;
+        for(std::size_t probe = 0;probe<m_numSlots;probe++) {
+            Slot &s = m_slots[i];
+            if(s.state == SLOT_EMPTY) {
+                return false;
             }
+            if(s.state == SLOT_OCCUPIED && s.kv.hash == h &&
+                    s.kv.key == k) {
+                s.kv = KeyVal<K, V>();
+                s.state = SLOT_DELETED;
+                m_numUsed--;
+                m_numDeleted++;
+                return true;
+            }
+            i = (i+1)&m_mask;
         }
+        return false;
+    }
 
-        list.pushBack(KeyVal<K, V>(k, V{}));
-        if((float)size()/capacity()>=m_loadFactor) {
-            rehash();
-            std::size_t newH = hash(k)%capacity();
-            auto &newList = m_buckets[newH];
-            return newList.tail().value;
+    // rebuilds only the occupied slots, so resizing to
+    // the current size purges the tombstones in place
+    void resize(std::size_t newSize) {
+        newSize = roundUpPow2(newSize);
+        if(!m_slots) {
+            m_slots = new Slot[newSize];
+            m_numSlots = newSize;
+            m_mask = newSize-1;
+        } else {
+            Slot *oldSlots = m_slots;
+            std::size_t oldNum = m_numSlots;
+            m_slots = new Slot[newSize];
+            m_numSlots = newSize;
+            m_mask = newSize-1;
+            m_numUsed = 0;
+            m_numDeleted = 0;
+            for(std::size_t i = 0;i<oldNum;i++) {
+                if(oldSlots[i].state == SLOT_OCCUPIED) {
+                    std::size_t h = oldSlots[i].kv.hash;
+                    insert(h, std::move(oldSlots[i].kv));
+                }
+            }
+            delete [] oldSlots;
         }
+    }
 
-        return list.tail().value;
+    std::size_t size() const {
+        return m_numSlots;
     }
 
-    V &operator[](const K &k) {
-        return get(k);
+    std::size_t used() const {
+        return m_numUsed;
     }
 
-    HashMapIterator<K, V> begin() const {
-        return HashMapIterator<K, V>(HASH_MAP_BEGIN, m_buckets);
+    // deleted slots stop probes just like occupied ones,
+    // so they count toward the load the map grows on
+    std::size_t deleted() const {
+        return m_numDeleted;
     }
 
-    HashMapIterator<K, V> end() const {
-        return HashMapIterator<K, V>(HASH_MAP_END, m_buckets);
+    // address of the first slot a probe for this
+    // hash will touch; used for prefetching
+    const void *slotAddr(std::size_t h) const {
+        return &m_slots[h&m_mask];
     }
 
 private:
+    Slot *m_slots;
+    std::size_t m_numSlots;
+    std::size_t m_mask;
+    std::size_t m_numUsed;
+    std::size_t m_numDeleted;
+};
+
+/**
+ * @brief Structure-of-arrays slot storage
+ *
+ * Keeps slot states, hashes, keys and values in
+ * separate parallel arrays. Probe loops touch
+ * only the state and hash arrays and key scans
+ * only states and keys, so sweeping the keys of
+ * a map with large values no longer drags every
+ * value through the cache.
+ */
+template <typename K, typename V>
+class SoAPool {
+public:
+    SoAPool(std::size_t size): m_states(nullptr),
+                               m_hashes(nullptr),
+                               m_keys(nullptr),
+                               m_values(nullptr),
+                               m_numSlots(0),
+                               m_numUsed(0),
+                               m_numDeleted(0),
+                               m_mask(0)
+    {
+        resize(size);
+    }
+
+    SoAPool(const SoAPool&) = delete;
+    SoAPool &operator=(const SoAPool&) = delete;
+
+    SoAPool(SoAPool &&other): m_states(other.m_states),
+                              m_hashes(other.m_hashes),
+                              m_keys(other.m_keys),
+                              m_values(other.m_values),
+                              m_numSlots(other.m_numSlots),
+                              m_numUsed(other.m_numUsed),
+                              m_numDeleted(other.m_numDeleted),
+                              m_mask(other.m_mask)
+    {
+        other.m_states = nullptr;
+        other.m_hashes = nullptr;
+        other.m_keys = nullptr;
+        other.m_values = nullptr;
+        other.m_numSlots = 0;
+        other.m_numUsed = 0;
+        other.m_numDeleted = 0;
+        other.m_mask = 0;
+    }
+
+    SoAPool &operator=(SoAPool &&other) {
+        if(this != &other) {
+            clear();
+            m_states = other.m_states;
+            m_hashes = other.m_hashes;
+            m_keys = other.m_keys;
+            m_values = other.m_values;
+            m_numSlots = other.m_numSlots;
+            m_numUsed = other.m_numUsed;
+            m_numDeleted = other.m_numDeleted;
+            m_mask = other.m_mask;
+            other.m_states = nullptr;
+            other.m_hashes = nullptr;
+            other.m_keys = nullptr;
+            other.m_values = nullptr;
+            other.m_numSlots = 0;
+            other.m_numUsed = 0;
+            other.m_numDeleted = 0;
+            other.m_mask = 0;
+        }
+        return *this;
+    }
+
+    ~SoAPool() {
+        clear();
+    }
+
+    void clear() {
+        delete [] m_states;
+        delete [] m_hashes;
+        delete [] m_keys;
+        delete [] m_values;
+        m_states = nullptr;
+        m_hashes = nullptr;
+        m_keys = nullptr;
+        m_values = nullptr;
+        m_numSlots = 0;
+        m_numUsed = 0;
+        m_numDeleted = 0;
+    }
+
+    // returns pointer to the value for given key
+    // or nullptr if the key is not present
+    template <typename LK>
+    V *find(std::size_t h, const LK &k) const {
+        assert(m_states);
+        std::size_t i = h&m_mask;
+        for(std::size_t probe = 0;probe<m_numSlots;probe++) {
+            if(m_states[i] == SLOT_EMPTY) {
+                return nullptr;
+            }
+            if(m_states[i] == SLOT_OCCUPIED && m_hashes[i] == h &&
+                    m_keys[i] == k) {
+                return &m_values[i];
+            }
+            i = (i+1)&m_mask;
+        }
+        return nullptr;
+    }
+
+    // inserts entry assuming the key is not present;
+    // caller is responsible for keeping the load below 1
+    V &insert(std::size_t h, K k, V v) {
+        assert(m_states);
+        assert(m_numUsed<m_numSlots);
+        std::size_t i = h&m_mask;
+        while(m_states[i] == SLOT_OCCUPIED) {
+            i = (i+1)&m_mask;
+        }
+        if(m_states[i] == SLOT_DELETED) {
+            m_numDeleted--;
+        }
+        m_states[i] = SLOT_OCCUPIED;
+        m_hashes[i] = h;
+        m_keys[i] = std::move(k);
+        m_values[i] = std::move(v);
+        m_numUsed++;
+        return m_values[i];
+    }
+
+    // marks the slot as deleted so later probes can
+    // skip over it; returns whether the key existed
+    template <typename LK>
+    bool erase(std::size_t h, const LK &k) {
+        assert(m_states);
+        std::size_t i = h&m_mask;
+        for(std::size_t probe = 0;probe<m_numSlots;probe++) {
+            if(m_states[i] == SLOT_EMPTY) {
+                return false;
+            }
+            if(m_states[i] == SLOT_OCCUPIED && m_hashes[i] == h &&
+                    m_keys[i] == k) {
+                m_states[i] = SLOT_DELETED;
+                m_keys[i] = K();
+                m_values[i] = V();
+                m_numUsed--;
+                m_numDeleted++;
+                return true;
+            }
+            i = (i+1)&m_mask;
+        }
+        return false;
+    }
+
+    // rebuilds only the occupied slots, so resizing to
+    // the current size purges the tombstones in place
+    void resize(std::size_t newSize) {
+        newSize = roundUpPow2(newSize);
+        std::uint8_t *oldStates = m_states;
+        std::size_t *oldHashes = m_hashes;
+        K *oldKeys = m_keys;
+        V *oldValues = m_values;
+        std::size_t oldNum = m_numSlots;
+
+        m_states = new std::uint8_t[newSize]();    // SLOT_EMPTY
+        m_hashes = new std::size_t[newSize];
+        m_keys = new K[newSize];
+        m_values = new V[newSize];
+        m_numSlots = newSize;
+        m_mask = newSize-1;
+        m_numUsed = 0;
+        m_numDeleted = 0;
+
+        if(oldStates) {
+            for(std::size_t i = 0;i<oldNum;i++) {
+                if(oldStates[i] == SLOT_OCCUPIED) {
+                    insert(oldHashes[i], std::move(oldKeys[i]),
+                           std::move(oldValues[i]));
+                }
+            }
+            delete [] oldStates;
+            delete [] oldHashes;
+            delete [] oldKeys;
+            delete [] oldValues;
+        }
+    }
+
+    std::size_t size() const {
+        return m_numSlots;
+    }
+
+    std::size_t used() const {
+        return m_numUsed;
+    }
+
+    // deleted slots stop probes just like occupied ones,
+    // so they count toward the load the map grows on
+    std::size_t deleted() const {
+        return m_numDeleted;
+    }
+
+    // address of the first hash a probe for this
+    // hash will touch; used for prefetching
+    const void *slotAddr(std::size_t h) const {
+        return &m_hashes[h&m_mask];
+    }
+
+    // visits every key without touching the value array
+    template <typename F>
+    void forEachKey(F f) const {
+        for(std::size_t i = 0;i<m_numSlots;i++) {
+            if(m_states[i] == SLOT_OCCUPIED) {
+                f(m_keys[i]);
+            }
+        }
+    }
+
+    template <typename F>
+    void forEach(F f) const {
+        for(std::size_t i = 0;i<m_numSlots;i++) {
+            if(m_states[i] == SLOT_OCCUPIED) {
+                f(m_keys[i], m_values[i]);
+            }
+        }
+    }
+
+private:
+    std::uint8_t *m_states;
+    std::size_t *m_hashes;
+    K *m_keys;
+    V *m_values;
+    std::size_t m_numSlots;
+    std::size_t m_numUsed;
+    std::size_t m_numDeleted;
+    std::size_t m_mask;
+};
+
+enum HashMapIteratorPos {
+    HASH_MAP_BEGIN,
+    HASH_MAP_END
+};
+
+/**
+ * @brief Forward iterator over a chained @HashMap
+ *
+ * Holds a direct node cursor and advances via
+ * ListItem::next, scanning for the next non-empty
+ * bucket only at chain ends, so a full iteration
+ * is a pure pointer walk.
+ */
+template <typename K, typename V, bool Lru = false>
+class HashMapIterator: public std::iterator<std::forward_iterator_tag, KeyVal<K, V>> {
+public:
+
+    explicit HashMapIterator(HashMapIteratorPos pos,
+                             const BucketPool<K, V, Lru> &pool):
+                                        m_pool(&pool),
+                                        m_curBucket(0),
+                                        m_curItem(nullptr),
+                                        m_array(nullptr),
+                                        m_arrayPos(0)
+    {
+        if(pos == HASH_MAP_BEGIN) {
+            findNextBucket();
+        } else {
+            // one past the last bucket with a null cursor;
+            // operator++ lands here after the last chain
+            m_curBucket = pool.size();
+        }
+    }
+
+    // iterates a small map's inline entry array
+    // instead of a bucket pool
+    explicit HashMapIterator(HashMapIteratorPos pos,
+                             KeyVal<K, V> *array,
+                             std::size_t count):
+                                        m_pool(nullptr),
+                                        m_curBucket(0),
+                                        m_curItem(nullptr),
+                                        m_array(array),
+                                        m_arrayPos(pos == HASH_MAP_BEGIN?
+                                                   0:count)
+    {}
+
+    // pre-increment
+    HashMapIterator<K, V, Lru> &operator++() {
+        if(m_array) {
+            m_arrayPos++;
+            return *this;
+        }
+        m_curItem = m_curItem->next;
+        if(!m_curItem) {
+            m_curBucket++;
+            findNextBucket();
+        }
+        return *this;
+    }
+
+    // post-increment
+    HashMapIterator<K, V, Lru> operator++(int) {
+        HashMapIterator itr(*this);
+        operator++();
+        return itr;
+    }
+
+    KeyVal<K, V> &operator*() const {
+        if(m_array) {
+            return m_array[m_arrayPos];
+        }
+        return m_curItem->value;
+    }
+
+    KeyVal<K, V> *operator->() const {
+        return &operator*();
+    }
+
+    bool operator==(const HashMapIterator &other) const {
+        if(m_array) {
+            return m_array == other.m_array &&
+                   m_arrayPos == other.m_arrayPos;
+        }
+        return m_pool == other.m_pool &&
+               m_curBucket == other.m_curBucket &&
+               m_curItem == other.m_curItem;
+    }
+
+    bool operator!=(const HashMapIterator &other) const {
+        return !operator==(other);
+    }
+
+private:
+    void findNextBucket() {
+        m_curItem = nullptr;
+        while(m_curBucket < m_pool->size()) {
+            if((*m_pool)[m_curBucket].head()) {
+                m_curItem = (*m_pool)[m_curBucket].head();
+                return;
+            }
+            m_curBucket++;
+        }
+    }
+
+private:
+    const BucketPool<K, V, Lru> *m_pool;
+    std::size_t m_curBucket;
+    ListItem<KeyVal<K, V>, Lru> *m_curItem;
+    KeyVal<K, V> *m_array;
+    std::size_t m_arrayPos;
+};
+
+/**
+ * @brief Counters scraped from an instrumented @HashMap
+ *
+ * Produced by stats() on maps built with the
+ * Instrumented template flag; meant for export
+ * into a metrics pipeline. probes/lookups tells
+ * the average walk length (hash quality), the
+ * chain histogram tells its spread, and the
+ * rehash counters tell whether growth cost is
+ * where the time went.
+ */
+struct HashMapStats {
+    std::uint64_t lookups;          // probe walks performed
+    std::uint64_t probes;           // key compares across all walks
+    std::uint64_t maxProbe;         // longest single walk
+    std::uint64_t inserts;
+    std::uint64_t overflowAllocs;   // inserts that chained a new node
+    std::uint64_t erases;
+    std::uint64_t rehashes;         // migrations started
+    std::uint64_t rehashNs;         // time spent migrating buckets
+    // chain lengths 0,1,2,3,4-7,8-15,16-31,32+
+    static const std::size_t CHAIN_HIST = 8;
+    std::uint64_t chainHist[CHAIN_HIST];
+};
+
+inline std::uint64_t statsNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Counter state behind the Instrumented flag
+ *
+ * The disabled variant is all empty inline
+ * methods, so an uninstrumented map compiles to
+ * exactly the code it had before the flag existed.
+ */
+template <bool Enabled>
+struct HashMapStatsState {
+    void countProbe(std::size_t) {}
+    void countInsert(bool) {}
+    void countErase() {}
+    void countRehash() {}
+    void addRehashNs(std::uint64_t) {}
+};
+
+template <>
+struct HashMapStatsState<true> {
+    HashMapStatsState(): lookups(0),
+                         probes(0),
+                         maxProbe(0),
+                         inserts(0),
+                         overflowAllocs(0),
+                         erases(0),
+                         rehashes(0),
+                         rehashNs(0)
+    {}
+
+    void countProbe(std::size_t n) {
+        lookups++;
+        probes += n;
+        maxProbe = std::max<std::uint64_t>(maxProbe, n);
+    }
+
+    void countInsert(bool overflow) {
+        inserts++;
+        overflowAllocs += overflow;
+    }
+
+    void countErase() {
+        erases++;
+    }
+
+    void countRehash() {
+        rehashes++;
+    }
+
+    void addRehashNs(std::uint64_t ns) {
+        rehashNs += ns;
+    }
+
+    std::uint64_t lookups;
+    std::uint64_t probes;
+    std::uint64_t maxProbe;
+    std::uint64_t inserts;
+    std::uint64_t overflowAllocs;
+    std::uint64_t erases;
+    std::uint64_t rehashes;
+    std::uint64_t rehashNs;
+};
+
+/**
+ * @brief Recency-list state behind the Lru flag
+ *
+ * Same pattern as @HashMapStatsState: the disabled
+ * variant is empty no-op methods, so unbounded maps
+ * carry neither the list head and tail nor the two
+ * per-node pointers of @LruLinks.
+ */
+template <typename Node, bool Lru>
+struct LruState {
+    void pushFront(Node*) {}
+    void unlink(Node*) {}
+    void touch(Node*) {}
+    void adopt(Node*, Node*) {}
+    Node *coldest() const { return nullptr; }
+    void reset() {}
+};
+
+template <typename Node>
+struct LruState<Node, true> {
+    LruState(): head(nullptr),
+                tail(nullptr)
+    {}
+
+    void pushFront(Node *i) {
+        i->lruPrev = nullptr;
+        i->lruNext = head;
+        if(head) {
+            head->lruPrev = i;
+        }
+        head = i;
+        if(!tail) {
+            tail = i;
+        }
+    }
+
+    void unlink(Node *i) {
+        if(i->lruPrev) {
+            i->lruPrev->lruNext = i->lruNext;
+        } else {
+            head = i->lruNext;
+        }
+        if(i->lruNext) {
+            i->lruNext->lruPrev = i->lruPrev;
+        } else {
+            tail = i->lruPrev;
+        }
+    }
+
+    void touch(Node *i) {
+        if(i == head) {
+            return;
+        }
+        unlink(i);
+        pushFront(i);
+    }
+
+    // removing a bucket head promotes the next node's
+    // entry into it and frees that node; hand the freed
+    // node's recency position to the head beforehand
+    void adopt(Node *dst, Node *src) {
+        dst->lruPrev = src->lruPrev;
+        dst->lruNext = src->lruNext;
+        if(src->lruPrev) {
+            src->lruPrev->lruNext = dst;
+        } else {
+            head = dst;
+        }
+        if(src->lruNext) {
+            src->lruNext->lruPrev = dst;
+        } else {
+            tail = dst;
+        }
+    }
+
+    Node *coldest() const {
+        return tail;
+    }
+
+    void reset() {
+        head = nullptr;
+        tail = nullptr;
+    }
+
+    Node *head;
+    Node *tail;
+};
+
+/**
+ * @brief A generic hash map
+ *
+ * The storage backend is selectable via
+ * the Storage template policy: @BucketPool
+ * (separate chaining, the default) or
+ * @OpenAddressPool (flat linear probing).
+ * The Instrumented flag compiles in the
+ * probe/chain/rehash counters behind
+ * stats(); disabled it costs nothing.
+ */
+template <typename K, typename V, typename Storage = BucketPool<K, V>,
+          bool Instrumented = false>
+class HashMap;
+
+template <typename K, typename V, bool Lru, bool Instrumented>
+class HashMap<K, V, BucketPool<K, V, Lru>, Instrumented> {
+public:
+    // the map starts in inline mode: entries live in a
+    // fixed array inside the object and no bucket pool
+    // is allocated until the count crosses INLINE_CAP.
+    // A nonzero maxEntries turns the map into a bounded
+    // LRU cache: the table is sized once for the cap,
+    // never rehashes, and inserts past the cap evict
+    // the least recently used entry. The cap requires
+    // the recency links compiled in — use @LruHashMap
+    HashMap( std::size_t capacity = 16, float loadFactor = 0.75,
+             std::size_t maxEntries = 0):
+                                        m_buckets(nullptr),
+                                        m_oldBuckets(nullptr),
+                                        m_migratePos(0),
+                                        m_mask(0),
+                                        m_loadFactor(loadFactor),
+                                        m_size(0),
+                                        m_spillCapacity(capacity),
+                                        m_maxEntries(maxEntries)
+    {
+        assert(Lru || !maxEntries);
+        if(m_maxEntries) {
+            spill(roundUpPow2(std::size_t(m_maxEntries/m_loadFactor)+1));
+        }
+    }
+
+    HashMap(HashMap &&other): m_buckets(other.m_buckets),
+                              m_oldBuckets(other.m_oldBuckets),
+                              m_migratePos(other.m_migratePos),
+                              m_mask(other.m_mask),
+                              m_loadFactor(other.m_loadFactor),
+                              m_size(other.m_size),
+                              m_spillCapacity(other.m_spillCapacity),
+                              m_maxEntries(other.m_maxEntries),
+                              m_lru(other.m_lru)
+    {
+        if(!m_buckets) {
+            for(std::size_t i = 0;i<m_size;i++) {
+                m_inline[i] = std::move(other.m_inline[i]);
+            }
+        }
+        other.m_buckets = nullptr;
+        other.m_oldBuckets = nullptr;
+        other.m_size = 0;
+        other.m_lru.reset();
+    }
+
+    HashMap &operator=(HashMap &&other) {
+        if(this != &other) {
+            delete m_buckets;
+            delete m_oldBuckets;
+            m_buckets = other.m_buckets;
+            m_oldBuckets = other.m_oldBuckets;
+            m_migratePos = other.m_migratePos;
+            m_mask = other.m_mask;
+            m_loadFactor = other.m_loadFactor;
+            m_size = other.m_size;
+            m_spillCapacity = other.m_spillCapacity;
+            m_maxEntries = other.m_maxEntries;
+            m_lru = other.m_lru;
+            if(!m_buckets) {
+                for(std::size_t i = 0;i<m_size;i++) {
+                    m_inline[i] = std::move(other.m_inline[i]);
+                }
+            }
+            other.m_buckets = nullptr;
+            other.m_oldBuckets = nullptr;
+            other.m_size = 0;
+            other.m_lru.reset();
+        }
+        return *this;
+    }
+
+    // bulk-load constructor; sizes the table for the
+    // whole range up front so loading never rehashes
+    template <typename It>
+    HashMap(It first, It last, float loadFactor = 0.75):
+                                        HashMap(16, loadFactor)
+    {
+        insert(first, last);
+    }
+
+    ~HashMap() {
+        delete m_buckets;
+        delete m_oldBuckets;
+    }
+
+    // pre-sizes the bucket pool for the expected
+    // element count based on the load factor
+    void reserve(std::size_t expectedElements) {
+        if(m_maxEntries) {
+            // capped maps are sized once for the cap
+            return;
+        }
+        std::size_t want = roundUpPow2(
+                std::size_t(expectedElements/m_loadFactor)+1);
+        if(!m_buckets) {
+            if(expectedElements>INLINE_CAP) {
+                spill(want);
+            }
+            return;
+        }
+        if(want<=capacity()) {
+            return;
+        }
+        finishMigration();
+        startMigration(want);
+        finishMigration();
+    }
+
+    /**
+     * @brief Builds a map from a large range with worker threads
+     *
+     * Pre-sizes the bucket array once, hashes all keys
+     * in parallel, then gives each worker a contiguous
+     * slice of the bucket array: a worker only inserts
+     * keys whose bucket falls in its slice, so no two
+     * threads ever touch the same list and no locking
+     * is needed. Overflow nodes come from per-worker
+     * arenas the pool adopts when the build finishes.
+     *
+     * Ranges below a threshold (or numThreads < 2)
+     * fall back to the sequential bulk path.
+     */
+    template <typename It>
+    static HashMap buildParallel(It first, It last,
+                                 std::size_t numThreads,
+                                 float loadFactor = 0.75) {
+        std::size_t n = std::distance(first, last);
+        HashMap map(16, loadFactor);
+        if(numThreads<2 || n<MIN_PARALLEL_BUILD) {
+            map.reserve(n);
+            map.insert(first, last);
+            return map;
+        }
+
+        map.reserve(n);
+        BucketPool<K, V, Lru> &pool = *map.m_buckets;
+        std::size_t mask = map.m_mask;
+        std::size_t numBuckets = pool.size();
+
+        // snapshot the range so workers can slice it
+        It *items = new It[n];
+        {
+            std::size_t i = 0;
+            for(It it = first; it != last; ++it) {
+                items[i++] = it;
+            }
+        }
+
+        // phase 1: hash every key in parallel; for
+        // string keys this is most of the build cost
+        std::size_t *hashes = new std::size_t[n];
+        std::thread *threads = new std::thread[numThreads];
+        for(std::size_t t = 0;t<numThreads;t++) {
+            std::size_t lo = n*t/numThreads;
+            std::size_t hi = n*(t+1)/numThreads;
+            threads[t] = std::thread([items, hashes, lo, hi]() {
+                for(std::size_t i = lo;i<hi;i++) {
+                    hashes[i] = hash(items[i]->key);
+                }
+            });
+        }
+        for(std::size_t t = 0;t<numThreads;t++) {
+            threads[t].join();
+        }
+
+        // phase 2: insert, one bucket slice per worker
+        NodeArena<ListItem<KeyVal<K, V>, Lru>> *arenas =
+                new NodeArena<ListItem<KeyVal<K, V>, Lru>>[numThreads];
+        std::size_t *counts = new std::size_t[numThreads]();
+        for(std::size_t t = 0;t<numThreads;t++) {
+            pool.setRangeArena(numBuckets*t/numThreads,
+                               numBuckets*(t+1)/numThreads,
+                               &arenas[t]);
+        }
+        for(std::size_t t = 0;t<numThreads;t++) {
+            std::size_t lo = numBuckets*t/numThreads;
+            std::size_t hi = numBuckets*(t+1)/numThreads;
+            threads[t] = std::thread([&pool, items, hashes, n, mask,
+                                      lo, hi, counts, t]() {
+                for(std::size_t i = 0;i<n;i++) {
+                    std::size_t b = hashes[i]&mask;
+                    if(b<lo || b>=hi) {
+                        continue;
+                    }
+                    auto &list = pool[b];
+                    // keep the first occurrence of a key,
+                    // matching emplace() semantics
+                    bool dup = false;
+                    for(ListItem<KeyVal<K, V>, Lru> *j = list.head(); j;
+                            j = j->next) {
+                        if(j->value.hash == hashes[i] &&
+                                j->value.key == items[i]->key) {
+                            dup = true;
+                            break;
+                        }
+                    }
+                    if(!dup) {
+                        list.pushBack(KeyVal<K, V>(items[i]->key,
+                                items[i]->value, hashes[i]));
+                        counts[t]++;
+                    }
+                }
+            });
+        }
+        for(std::size_t t = 0;t<numThreads;t++) {
+            threads[t].join();
+        }
+
+        pool.setRangeArena(0, numBuckets, nullptr);
+        for(std::size_t t = 0;t<numThreads;t++) {
+            pool.adoptArena(std::move(arenas[t]));
+            map.m_size += counts[t];
+        }
+
+        delete [] counts;
+        delete [] arenas;
+        delete [] threads;
+        delete [] hashes;
+        delete [] items;
+        return map;
+    }
+
+    // rehashes down to a bucket count matching the
+    // current element count, returning the memory the
+    // map grew into at its peak; maps small enough
+    // move back into the inline array entirely
+    void shrinkToFit() {
+        if(!m_buckets || m_maxEntries) {
+            return;
+        }
+        finishMigration();
+        if(m_size<=INLINE_CAP) {
+            unspill();
+            return;
+        }
+        std::size_t want = roundUpPow2(
+                std::size_t(m_size/m_loadFactor)+1);
+        if(want>=capacity()) {
+            return;
+        }
+        startMigration(want);
+        finishMigration();
+    }
+
+    // inserts a range of KeyVal entries, growing the
+    // table at most once for the whole batch
+    template <typename It>
+    void insert(It first, It last) {
+        reserve(size()+std::distance(first, last));
+        for(It i = first; i != last; ++i) {
+            emplace(i->key, i->value);
+        }
+    }
+
+    /**
+     * @brief Inserts a batch of entries in one pass
+     *
+     * Grows the table at most once up front, then
+     * hashes the keys a chunk at a time and
+     * prefetches the target buckets before probing —
+     * the batched counterpart of getMany(). No rehash
+     * can land mid-batch and the load factor is
+     * checked once instead of n times. Existing keys
+     * keep their value, matching emplace().
+     */
+    void insertBatch(const KeyVal<K, V> *items, std::size_t n) {
+        if(m_maxEntries) {
+            // capped maps evict instead of growing, so
+            // batch pre-sizing does not apply
+            for(std::size_t i = 0;i<n;i++) {
+                emplace(items[i].key, items[i].value);
+            }
+            return;
+        }
+        reserve(size()+n);
+        if(!m_buckets) {
+            for(std::size_t i = 0;i<n;i++) {
+                emplace(items[i].key, items[i].value);
+            }
+            return;
+        }
+        finishMigration();
+
+        const std::size_t CHUNK = 16;
+        std::size_t hashes[CHUNK];
+        for(std::size_t base = 0;base<n;base += CHUNK) {
+            std::size_t m = std::min(CHUNK, n-base);
+            for(std::size_t i = 0;i<m;i++) {
+                hashes[i] = hash(items[base+i].key);
+                prefetchRead(&(*m_buckets)[hashes[i]&m_mask]);
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                prefetchRead((*m_buckets)[hashes[i]&m_mask].head());
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                if(findHashed(hashes[i], items[base+i].key)) {
+                    continue;
+                }
+                auto &list = (*m_buckets)[hashes[i]&m_mask];
+                list.pushBack(KeyVal<K, V>(items[base+i].key,
+                                           items[base+i].value,
+                                           hashes[i]));
+                m_size++;
+                m_stats.countInsert(list.size()>1);
+            }
+        }
+    }
+
+    std::size_t capacity() const {
+        return m_buckets?m_buckets->size():INLINE_CAP;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    float getLoad() const {
+        return (float)size()/capacity();
+    }
+
+    // looks the key up without inserting; returns
+    // nullptr when absent. The pointer is invalidated
+    // by subsequent inserts, like any rehash would.
+    // Accepts any type hashable and comparable with
+    // K (@StringRef, C strings, ...) so probing from
+    // a parsed buffer never allocates a key
+    template <typename LK>
+    V *find(const LK &k) {
+        if(!m_buckets) {
+            return inlineFind(hash(k), k);
+        }
+        if(m_maxEntries) {
+            ListItem<KeyVal<K, V>, Lru> *i = findItem(hash(k), k);
+            if(!i) {
+                return nullptr;
+            }
+            m_lru.touch(i);
+            return &i->value.value;
+        }
+        migrateStep();
+        return findHashed(hash(k), k);
+    }
+
+    // batch lookup: hashes every key first, prefetches
+    // the target buckets and their chain heads, then
+    // resolves the probes; out[i] is nullptr when
+    // keys[i] is absent
+    void getMany(const K *keys, std::size_t n, V **out) {
+        if(m_buckets && m_maxEntries) {
+            // go through find() so batch lookups update
+            // recency like single ones
+            for(std::size_t i = 0;i<n;i++) {
+                out[i] = find(keys[i]);
+            }
+            return;
+        }
+        if(!m_buckets) {
+            // inline entries fit in a cache line or two;
+            // prefetching buys nothing here
+            for(std::size_t i = 0;i<n;i++) {
+                out[i] = inlineFind(hash(keys[i]), keys[i]);
+            }
+            return;
+        }
+
+        migrateStep();
+
+        const std::size_t CHUNK = 16;
+        std::size_t hashes[CHUNK];
+        for(std::size_t base = 0;base<n;base += CHUNK) {
+            std::size_t m = std::min(CHUNK, n-base);
+            for(std::size_t i = 0;i<m;i++) {
+                hashes[i] = hash(keys[base+i]);
+                prefetchRead(&(*m_buckets)[hashes[i]&m_mask]);
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                prefetchRead((*m_buckets)[hashes[i]&m_mask].head());
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                out[base+i] = findHashed(hashes[i], keys[base+i]);
+            }
+        }
+    }
+
+private:
+    template <typename LK>
+    V *inlineFind(std::size_t h, const LK &k) {
+        for(std::size_t i = 0;i<m_size;i++) {
+            if(m_inline[i].hash == h && m_inline[i].key == k) {
+                m_stats.countProbe(i+1);
+                return &m_inline[i].value;
+            }
+        }
+        m_stats.countProbe(m_size);
+        return nullptr;
+    }
+
+    // node-level lookup for the LRU paths; capped maps
+    // never migrate, so only the current pool is probed
+    template <typename LK>
+    ListItem<KeyVal<K, V>, Lru> *findItem(std::size_t h, const LK &k) {
+        std::size_t probe = 0;
+        auto &list = (*m_buckets)[h&m_mask];
+        for(ListItem<KeyVal<K, V>, Lru> *i = list.head(); i; i = i->next) {
+            probe++;
+            if(i->value.hash == h && i->value.key == k) {
+                m_stats.countProbe(probe);
+                return i;
+            }
+        }
+        m_stats.countProbe(probe);
+        return nullptr;
+    }
+
+    // assumes the map has spilled to bucket storage
+    template <typename LK>
+    V *findHashed(std::size_t h, const LK &k) {
+        std::size_t probe = 0;
+        auto &list = (*m_buckets)[h&m_mask];
+        for(ListItem<KeyVal<K, V>, Lru> *i = list.head(); i; i = i->next) {
+            probe++;
+            if(i->value.hash == h && i->value.key == k) {
+                m_stats.countProbe(probe);
+                return &i->value.value;
+            }
+        }
+
+        // during migration the entry may still live in the
+        // old pool; move it over on access. The old node is
+        // unlinked so the key is never live in both pools —
+        // otherwise erase() would drop only the new copy and
+        // migrating the old bucket would resurrect the key
+        if(m_oldBuckets) {
+            auto &oldList = (*m_oldBuckets)[h&m_oldBuckets->mask()];
+            for(ListItem<KeyVal<K, V>, Lru> *i = oldList.head(); i; i = i->next) {
+                probe++;
+                if(i->value.hash == h && i->value.key == k) {
+                    list.pushBack(i->value);
+                    oldList.remove(i);
+                    m_stats.countProbe(probe);
+                    return &list.tail().value;
+                }
+            }
+        }
+
+        m_stats.countProbe(probe);
+        return nullptr;
+    }
+
+public:
+    template <typename LK>
+    bool contains(const LK &k) const {
+        std::size_t h = hash(k);
+        std::size_t probe = 0;
+        if(!m_buckets) {
+            for(std::size_t i = 0;i<m_size;i++) {
+                if(m_inline[i].hash == h && m_inline[i].key == k) {
+                    m_stats.countProbe(i+1);
+                    return true;
+                }
+            }
+            m_stats.countProbe(m_size);
+            return false;
+        }
+        auto &list = (*m_buckets)[h&m_mask];
+        for(ListItem<KeyVal<K, V>, Lru> *i = list.head(); i; i = i->next) {
+            probe++;
+            if(i->value.hash == h && i->value.key == k) {
+                m_stats.countProbe(probe);
+                return true;
+            }
+        }
+        if(m_oldBuckets) {
+            auto &oldList = (*m_oldBuckets)[h&m_oldBuckets->mask()];
+            for(ListItem<KeyVal<K, V>, Lru> *i = oldList.head(); i; i = i->next) {
+                probe++;
+                if(i->value.hash == h && i->value.key == k) {
+                    m_stats.countProbe(probe);
+                    return true;
+                }
+            }
+        }
+        m_stats.countProbe(probe);
+        return false;
+    }
+
+    // removes the entry for the key; returns whether
+    // it existed. The freed node goes back to the
+    // arena free list for reuse by later inserts
+    template <typename LK>
+    bool erase(const LK &k) {
+        std::size_t h = hash(k);
+        if(!m_buckets) {
+            for(std::size_t i = 0;i<m_size;i++) {
+                if(m_inline[i].hash == h && m_inline[i].key == k) {
+                    m_inline[i] = std::move(m_inline[m_size-1]);
+                    m_size--;
+                    m_stats.countErase();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        migrateStep();
+
+        auto &list = (*m_buckets)[h&m_mask];
+        for(ListItem<KeyVal<K, V>, Lru> *i = list.head(); i; i = i->next) {
+            if(i->value.hash == h && i->value.key == k) {
+                if(m_maxEntries) {
+                    m_lru.unlink(i);
+                    if(i == list.head() && i->next) {
+                        m_lru.adopt(i, i->next);
+                    }
+                }
+                list.remove(i);
+                m_size--;
+                m_stats.countErase();
+                maybeShrink();
+                return true;
+            }
+        }
+
+        if(m_oldBuckets) {
+            auto &oldList = (*m_oldBuckets)[h&m_oldBuckets->mask()];
+            for(ListItem<KeyVal<K, V>, Lru> *i = oldList.head(); i; i = i->next) {
+                if(i->value.hash == h && i->value.key == k) {
+                    oldList.remove(i);
+                    m_size--;
+                    m_stats.countErase();
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // returns the existing value for the key or
+    // constructs one in place from args
+    template <typename... Args>
+    V &emplace(K k, Args&&... args) {
+        std::size_t h = hash(k);
+        if(m_maxEntries) {
+            ListItem<KeyVal<K, V>, Lru> *i = findItem(h, k);
+            if(i) {
+                m_lru.touch(i);
+                return i->value.value;
+            }
+            if(m_size>=m_maxEntries) {
+                evictColdest();
+            }
+            auto &list = (*m_buckets)[h&m_mask];
+            list.pushBack(KeyVal<K, V>(std::move(k),
+                                       V(std::forward<Args>(args)...), h));
+            m_size++;
+            m_stats.countInsert(list.size()>1);
+            m_lru.pushFront(list.tailItem());
+            return list.tail().value;
+        }
+        if(!m_buckets) {
+            V *v = inlineFind(h, k);
+            if(v) {
+                return *v;
+            }
+            if(m_size<INLINE_CAP) {
+                m_inline[m_size] = KeyVal<K, V>(std::move(k),
+                        V(std::forward<Args>(args)...), h);
+                m_stats.countInsert(false);
+                return m_inline[m_size++].value;
+            }
+            spill();
+        } else {
+            migrateStep();
+            V *v = findHashed(h, k);
+            if(v) {
+                return *v;
+            }
+        }
+
+        auto &list = (*m_buckets)[h&m_mask];
+        list.pushBack(KeyVal<K, V>(std::move(k),
+                                   V(std::forward<Args>(args)...), h));
+        m_size++;
+        m_stats.countInsert(list.size()>1);
+        if(!m_oldBuckets && (float)m_size/capacity()>=m_loadFactor) {
+            // the pool we inserted into becomes the old one;
+            // re-probe so the returned reference points into
+            // the current pool. The key is copied out first
+            // since migration may drain the node it lives in
+            K inserted = list.tail().key;
+            startMigration();
+            return *find(inserted);
+        }
+
+        return list.tail().value;
+    }
+
+    V &get(const K &k) {
+        return emplace(k);
+    }
+
+    V &operator[](const K &k) {
+        return get(k);
+    }
+
+    // scrapes the counters plus a chain-length
+    // histogram of the bucket array; only available
+    // on maps built with the Instrumented flag. An
+    // inline-mode map reports its array as a single
+    // chain
+    template <bool E = Instrumented>
+    typename std::enable_if<E, HashMapStats>::type stats() {
+        finishMigration();
+        HashMapStats s = {};
+        s.lookups = m_stats.lookups;
+        s.probes = m_stats.probes;
+        s.maxProbe = m_stats.maxProbe;
+        s.inserts = m_stats.inserts;
+        s.overflowAllocs = m_stats.overflowAllocs;
+        s.erases = m_stats.erases;
+        s.rehashes = m_stats.rehashes;
+        s.rehashNs = m_stats.rehashNs;
+        if(m_buckets) {
+            for(std::size_t i = 0;i<m_buckets->size();i++) {
+                s.chainHist[chainBin((*m_buckets)[i].size())]++;
+            }
+        } else {
+            s.chainHist[chainBin(m_size)]++;
+        }
+        return s;
+    }
+
+    HashMapIterator<K, V, Lru> begin() {
+        if(!m_buckets) {
+            return HashMapIterator<K, V, Lru>(HASH_MAP_BEGIN, m_inline, m_size);
+        }
+        finishMigration();
+        return HashMapIterator<K, V, Lru>(HASH_MAP_BEGIN, *m_buckets);
+    }
+
+    HashMapIterator<K, V, Lru> end() {
+        if(!m_buckets) {
+            return HashMapIterator<K, V, Lru>(HASH_MAP_END, m_inline, m_size);
+        }
+        finishMigration();
+        return HashMapIterator<K, V, Lru>(HASH_MAP_END, *m_buckets);
+    }
+
+private:
+    // number of old buckets migrated per map operation;
+    // bounds the latency any single get() can add
+    static const std::size_t MIGRATE_STEP = 16;
+
+    // below this the thread spawn/join overhead beats
+    // any parallel speedup; buildParallel() goes
+    // sequential instead
+    static const std::size_t MIN_PARALLEL_BUILD = 4096;
+
+    // drops the least recently used entry to make room
+    void evictColdest() {
+        ListItem<KeyVal<K, V>, Lru> *t = m_lru.coldest();
+        assert(t);
+        auto &list = (*m_buckets)[t->value.hash&m_mask];
+        m_lru.unlink(t);
+        if(t == list.head() && t->next) {
+            m_lru.adopt(t, t->next);
+        }
+        list.remove(t);
+        m_size--;
+        m_stats.countErase();
+    }
+
+    static std::size_t chainBin(std::size_t len) {
+        if(len<4) {
+            return len;
+        }
+        if(len<8) {
+            return 4;
+        }
+        if(len<16) {
+            return 5;
+        }
+        if(len<32) {
+            return 6;
+        }
+        return HashMapStats::CHAIN_HIST-1;
+    }
+
+    /**
+     * @brief Moves the inline entries into bucket storage
+     *
+     * Called once the element count outgrows the
+     * inline array (or a reserve() asks for more).
+     */
+    void spill(std::size_t numBuckets = 0) {
+        assert(!m_buckets);
+        if(!numBuckets) {
+            numBuckets = std::max(m_spillCapacity, 2*INLINE_CAP);
+        }
+        m_buckets = new BucketPool<K, V, Lru>(numBuckets);
+        m_mask = m_buckets->mask();
+        for(std::size_t i = 0;i<m_size;i++) {
+            (*m_buckets)[m_inline[i].hash&m_mask].pushBack(
+                    std::move(m_inline[i]));
+        }
+    }
+
     /**
-     * @brief Increases bucket count and
-     * performs complete rehashing of data
+     * @brief Inverse of spill()
+     *
+     * Moves the remaining entries back into the
+     * inline array and frees the bucket pool.
      */
-    void rehash() {
-        KeyVal<K, V> *tempStorage = new KeyVal<K, V>[size()];
+    void unspill() {
+        assert(m_buckets && !m_oldBuckets);
+        assert(m_size<=INLINE_CAP);
         std::size_t n = 0;
-        for(int i = 0;i<m_buckets.size();i++) {
-            auto &b = m_buckets[i];
-            for(int j = 0;j<b.size();j++) {
-                tempStorage[n++] = b[j];
+        for(std::size_t b = 0;b<m_buckets->size();b++) {
+            for(ListItem<KeyVal<K, V>, Lru> *i = (*m_buckets)[b].head(); i;
+                    i = i->next) {
+                m_inline[n++] = std::move(i->value);
+            }
+        }
+        delete m_buckets;
+        m_buckets = nullptr;
+        m_mask = 0;
+    }
+
+    // erase-driven shrink: once the load drops below a
+    // quarter of the growth threshold, start rehashing
+    // down incrementally so a purged map does not hold
+    // its peak-size bucket array forever
+    void maybeShrink() {
+        if(m_maxEntries || m_oldBuckets || capacity()<=2*INLINE_CAP ||
+                (float)m_size/capacity()>=m_loadFactor/4) {
+            return;
+        }
+        std::size_t want = std::max(roundUpPow2(
+                std::size_t(m_size/m_loadFactor)+1), 2*INLINE_CAP);
+        if(want<capacity()) {
+            startMigration(want);
+        }
+    }
+
+    /**
+     * @brief Starts an incremental rehash
+     *
+     * The current pool becomes the old one and a
+     * pool with twice the bucket count takes its
+     * place; subsequent operations migrate a few
+     * old buckets each until the old pool drains.
+     */
+    void startMigration(std::size_t newSize = 0) {
+        assert(!m_oldBuckets);
+        m_stats.countRehash();
+        m_oldBuckets = m_buckets;
+        if(!newSize) {
+            newSize = m_oldBuckets->size()*2;
+        }
+        m_buckets = new BucketPool<K, V, Lru>(newSize);
+        m_mask = m_buckets->mask();
+        m_migratePos = 0;
+    }
+
+    void migrateStep() {
+        if(!m_oldBuckets) {
+            return;
+        }
+
+        std::uint64_t t0 = Instrumented ? statsNowNs() : 0;
+        std::size_t step = MIGRATE_STEP;
+        while(step-- && m_migratePos<m_oldBuckets->size()) {
+            migrateBucket(m_migratePos++);
+        }
+
+        if(m_migratePos == m_oldBuckets->size()) {
+            delete m_oldBuckets;
+            m_oldBuckets = nullptr;
+        }
+        if(Instrumented) {
+            m_stats.addRehashNs(statsNowNs()-t0);
+        }
+    }
+
+    void finishMigration() {
+        while(m_oldBuckets) {
+            migrateStep();
+        }
+    }
+
+    void migrateBucket(std::size_t n) {
+        // entries touched by find() since the migration
+        // started were moved out of this list already, so
+        // whatever remains belongs to the current pool
+        auto &list = (*m_oldBuckets)[n];
+        for(ListItem<KeyVal<K, V>, Lru> *i = list.head(); i; i = i->next) {
+            (*m_buckets)[i->value.hash&m_mask].pushBack(i->value);
+        }
+        list.reset();
+    }
+
+private:
+    // entries held inline before the first spill;
+    // sized so typical tiny maps (HTTP header sets
+    // and the like) never touch the heap
+    static const std::size_t INLINE_CAP = 8;
+
+    BucketPool<K, V, Lru> *m_buckets;
+    BucketPool<K, V, Lru> *m_oldBuckets;
+    std::size_t m_migratePos;
+    std::size_t m_mask;
+    float m_loadFactor;
+    std::size_t m_size;
+    std::size_t m_spillCapacity;
+    // bounded-cache state; m_maxEntries is only ever
+    // nonzero when the Lru flag compiled the recency
+    // list in, and m_lru is empty state otherwise
+    std::size_t m_maxEntries;
+    LruState<ListItem<KeyVal<K, V>, Lru>, Lru> m_lru;
+    // mutable so const probes (contains) can count too
+    mutable HashMapStatsState<Instrumented> m_stats;
+    KeyVal<K, V> m_inline[INLINE_CAP];
+};
+
+/**
+ * @brief Open-addressing specialization of @HashMap
+ *
+ * Keeps the same get()/operator[] interface
+ * but resolves lookups by probing the flat
+ * slot array of @OpenAddressPool.
+ */
+template <typename K, typename V, bool Instrumented>
+class HashMap<K, V, OpenAddressPool<K, V>, Instrumented> {
+public:
+    HashMap( std::size_t capacity = 16, float loadFactor = 0.75):
+                                        m_slots(capacity),
+                                        m_loadFactor(loadFactor)
+    {}
+
+    template <typename It>
+    HashMap(It first, It last, float loadFactor = 0.75):
+                                        HashMap(16, loadFactor)
+    {
+        insert(first, last);
+    }
+
+    void reserve(std::size_t expectedElements) {
+        std::size_t want = roundUpPow2(
+                std::size_t(expectedElements/m_loadFactor)+1);
+        if(want>capacity()) {
+            m_slots.resize(want);
+        }
+    }
+
+    template <typename It>
+    void insert(It first, It last) {
+        reserve(size()+std::distance(first, last));
+        for(It i = first; i != last; ++i) {
+            emplace(i->key, i->value);
+        }
+    }
+
+    std::size_t capacity() const {
+        return m_slots.size();
+    }
+
+    std::size_t size() const {
+        return m_slots.used();
+    }
+
+    float getLoad() const {
+        return (float)size()/capacity();
+    }
+
+    template <typename LK>
+    V *find(const LK &k) const {
+        return m_slots.find(hash(k), k);
+    }
+
+    template <typename LK>
+    bool contains(const LK &k) const {
+        return find(k) != nullptr;
+    }
+
+    template <typename LK>
+    bool erase(const LK &k) {
+        return m_slots.erase(hash(k), k);
+    }
+
+    void getMany(const K *keys, std::size_t n, V **out) const {
+        const std::size_t CHUNK = 16;
+        std::size_t hashes[CHUNK];
+        for(std::size_t base = 0;base<n;base += CHUNK) {
+            std::size_t m = std::min(CHUNK, n-base);
+            for(std::size_t i = 0;i<m;i++) {
+                hashes[i] = hash(keys[base+i]);
+                prefetchRead(m_slots.slotAddr(hashes[i]));
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                out[base+i] = m_slots.find(hashes[i], keys[base+i]);
+            }
+        }
+    }
+
+    // eager counterpart of the chained backend's
+    // incremental shrink; one rehash, done
+    void shrinkToFit() {
+        std::size_t want = roundUpPow2(
+                std::size_t(size()/m_loadFactor)+1);
+        if(want<capacity()) {
+            m_slots.resize(want);
+        }
+    }
+
+    template <typename... Args>
+    V &emplace(K k, Args&&... args) {
+        std::size_t h = hash(k);
+        V *v = m_slots.find(h, k);
+        if(v) {
+            return *v;
+        }
+
+        // tombstones count toward the load: once the EMPTY
+        // slots run out every miss degrades into a scan of
+        // the whole table. Grow when live entries warrant
+        // it; when churn left the load mostly tombstones,
+        // rehash in place at the same size to purge them
+        if((float)(size()+m_slots.deleted()+1)/capacity()>=m_loadFactor) {
+            m_slots.resize((float)(size()+1)/capacity()>=m_loadFactor ?
+                           m_slots.size()*2 : m_slots.size());
+        }
+
+        return m_slots.insert(h,
+                KeyVal<K, V>(std::move(k),
+                             V(std::forward<Args>(args)...), h));
+    }
+
+    V &get(const K &k) {
+        return emplace(k);
+    }
+
+    V &operator[](const K &k) {
+        return get(k);
+    }
+
+private:
+    OpenAddressPool<K, V> m_slots;
+    float m_loadFactor;
+};
+
+/**
+ * @brief Structure-of-arrays specialization of @HashMap
+ *
+ * Same interface as the open-addressing
+ * backend, but backed by @SoAPool's parallel
+ * arrays; forEachKey() sweeps the packed key
+ * array at full cache-line utilization, which
+ * is what analytics-style key scans want.
+ */
+template <typename K, typename V, bool Instrumented>
+class HashMap<K, V, SoAPool<K, V>, Instrumented> {
+public:
+    HashMap( std::size_t capacity = 16, float loadFactor = 0.75):
+                                        m_slots(capacity),
+                                        m_loadFactor(loadFactor)
+    {}
+
+    template <typename It>
+    HashMap(It first, It last, float loadFactor = 0.75):
+                                        HashMap(16, loadFactor)
+    {
+        insert(first, last);
+    }
+
+    void reserve(std::size_t expectedElements) {
+        std::size_t want = roundUpPow2(
+                std::size_t(expectedElements/m_loadFactor)+1);
+        if(want>capacity()) {
+            m_slots.resize(want);
+        }
+    }
+
+    template <typename It>
+    void insert(It first, It last) {
+        reserve(size()+std::distance(first, last));
+        for(It i = first; i != last; ++i) {
+            emplace(i->key, i->value);
+        }
+    }
+
+    std::size_t capacity() const {
+        return m_slots.size();
+    }
+
+    std::size_t size() const {
+        return m_slots.used();
+    }
+
+    float getLoad() const {
+        return (float)size()/capacity();
+    }
+
+    void shrinkToFit() {
+        std::size_t want = roundUpPow2(
+                std::size_t(size()/m_loadFactor)+1);
+        if(want<capacity()) {
+            m_slots.resize(want);
+        }
+    }
+
+    template <typename LK>
+    V *find(const LK &k) const {
+        return m_slots.find(hash(k), k);
+    }
+
+    template <typename LK>
+    bool contains(const LK &k) const {
+        return find(k) != nullptr;
+    }
+
+    template <typename LK>
+    bool erase(const LK &k) {
+        return m_slots.erase(hash(k), k);
+    }
+
+    void getMany(const K *keys, std::size_t n, V **out) const {
+        const std::size_t CHUNK = 16;
+        std::size_t hashes[CHUNK];
+        for(std::size_t base = 0;base<n;base += CHUNK) {
+            std::size_t m = std::min(CHUNK, n-base);
+            for(std::size_t i = 0;i<m;i++) {
+                hashes[i] = hash(keys[base+i]);
+                prefetchRead(m_slots.slotAddr(hashes[i]));
+            }
+            for(std::size_t i = 0;i<m;i++) {
+                out[base+i] = m_slots.find(hashes[i], keys[base+i]);
             }
         }
+    }
+
+    // key-only sweep; never touches the value array
+    template <typename F>
+    void forEachKey(F f) const {
+        m_slots.forEachKey(f);
+    }
+
+    template <typename F>
+    void forEach(F f) const {
+        m_slots.forEach(f);
+    }
 
-        std::size_t numBuckets = m_buckets.size();
-        m_buckets.clear();
-        m_buckets.resize(numBuckets*2);
+    template <typename... Args>
+    V &emplace(K k, Args&&... args) {
+        std::size_t h = hash(k);
+        V *v = m_slots.find(h, k);
+        if(v) {
+            return *v;
+        }
 
-        for(int i = 0;i<n;i++) {
-            std::size_t h = hash(tempStorage[i].key)%capacity();
-            auto &bucket = m_buckets[h];
-            bucket.pushBack(tempStorage[i]);
+        // same tombstone accounting as the open-addressing
+        // backend: grow for live entries, rehash in place
+        // when churn left the load mostly tombstones
+        if((float)(size()+m_slots.deleted()+1)/capacity()>=m_loadFactor) {
+            m_slots.resize((float)(size()+1)/capacity()>=m_loadFactor ?
+                           m_slots.size()*2 : m_slots.size());
         }
+
+        return m_slots.insert(h, std::move(k),
+                              V(std::forward<Args>(args)...));
+    }
+
+    V &get(const K &k) {
+        return emplace(k);
+    }
+
+    V &operator[](const K &k) {
+        return get(k);
     }
 
 private:
-    BucketPool<K, V> m_buckets;
+    SoAPool<K, V> m_slots;
     float m_loadFactor;
 };
 
+template <typename K, typename V>
+using OpenHashMap = HashMap<K, V, OpenAddressPool<K, V>>;
+
+// structure-of-arrays backend for scan-heavy loads
+template <typename K, typename V>
+using SoAHashMap = HashMap<K, V, SoAPool<K, V>>;
+
+// chained map with the stats() counters compiled in
+template <typename K, typename V>
+using InstrumentedHashMap = HashMap<K, V, BucketPool<K, V>, true>;
+
+// chained map with the recency links compiled in;
+// required for the bounded maxEntries cache mode so
+// unbounded maps do not pay two pointers per node
+template <typename K, typename V>
+using LruHashMap = HashMap<K, V, BucketPool<K, V, true>>;
+
 #endif // HASH_MAP
@@ -0,0 +1,187 @@
+#include "HashMap.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmark driver for HashMap.
+ *
+ * Measures insert, hit/miss lookup and iteration
+ * throughput plus per-operation latency percentiles
+ * for the chained and open-addressing backends over
+ * uint32->uint64 and string->string maps, and prints
+ * one CSV row per measurement for perf CI diffing.
+ *
+ * Usage: HashMapBench [maxElements]
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+// keeps the optimizer from discarding lookup results
+static volatile std::size_t g_sink;
+
+static std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+}
+
+struct Percentiles {
+    double p50;
+    double p99;
+};
+
+static Percentiles percentiles(std::vector<std::uint64_t> &samples) {
+    Percentiles p = {0, 0};
+    if(samples.empty()) {
+        return p;
+    }
+    std::sort(samples.begin(), samples.end());
+    p.p50 = samples[samples.size()/2];
+    p.p99 = samples[std::min(samples.size()-1, samples.size()*99/100)];
+    return p;
+}
+
+static void report(const char *backend, const char *keyType,
+                   const char *op, float loadFactor,
+                   std::size_t numElem, std::uint64_t totalNs,
+                   std::vector<std::uint64_t> &samples) {
+    Percentiles p = percentiles(samples);
+    double mops = totalNs ? (double)numElem*1e3/totalNs : 0;
+    std::printf("%s,%s,%s,%.2f,%zu,%.3f,%.0f,%.0f\n",
+                backend, keyType, op, loadFactor, numElem,
+                mops, p.p50, p.p99);
+}
+
+// samples every 64th operation to keep timing
+// overhead out of the measured loop
+static const std::size_t SAMPLE_STRIDE = 64;
+
+template <typename Map, typename KeyGen>
+static void benchMap(const char *backend, const char *keyType,
+                     std::size_t numElem, KeyGen keyGen,
+                     float loadFactor) {
+    Map map(16, loadFactor);
+    std::vector<std::uint64_t> samples;
+    samples.reserve(numElem/SAMPLE_STRIDE+1);
+
+    std::uint64_t start = nowNs();
+    for(std::size_t i = 0;i<numElem;i++) {
+        if(i%SAMPLE_STRIDE == 0) {
+            std::uint64_t t0 = nowNs();
+            map[keyGen(i)];
+            samples.push_back(nowNs()-t0);
+        } else {
+            map[keyGen(i)];
+        }
+    }
+    report(backend, keyType, "insert", loadFactor, numElem, nowNs()-start, samples);
+
+    samples.clear();
+    start = nowNs();
+    for(std::size_t i = 0;i<numElem;i++) {
+        if(i%SAMPLE_STRIDE == 0) {
+            std::uint64_t t0 = nowNs();
+            g_sink += map.find(keyGen(i)) != nullptr;
+            samples.push_back(nowNs()-t0);
+        } else {
+            g_sink += map.find(keyGen(i)) != nullptr;
+        }
+    }
+    report(backend, keyType, "lookup_hit", loadFactor, numElem, nowNs()-start, samples);
+
+    samples.clear();
+    start = nowNs();
+    for(std::size_t i = 0;i<numElem;i++) {
+        if(i%SAMPLE_STRIDE == 0) {
+            std::uint64_t t0 = nowNs();
+            g_sink += map.find(keyGen(i+numElem)) != nullptr;
+            samples.push_back(nowNs()-t0);
+        } else {
+            g_sink += map.find(keyGen(i+numElem)) != nullptr;
+        }
+    }
+    report(backend, keyType, "lookup_miss", loadFactor, numElem, nowNs()-start, samples);
+
+    samples.clear();
+    start = nowNs();
+    for(std::size_t i = 0;i<numElem;i++) {
+        if(i%SAMPLE_STRIDE == 0) {
+            std::uint64_t t0 = nowNs();
+            g_sink += map.erase(keyGen(i));
+            samples.push_back(nowNs()-t0);
+        } else {
+            g_sink += map.erase(keyGen(i));
+        }
+    }
+    report(backend, keyType, "erase", loadFactor, numElem, nowNs()-start, samples);
+}
+
+template <typename Map, typename KeyGen>
+static void benchIterate(const char *backend, const char *keyType,
+                         std::size_t numElem, KeyGen keyGen,
+                         float loadFactor) {
+    Map map(16, loadFactor);
+    for(std::size_t i = 0;i<numElem;i++) {
+        map[keyGen(i)];
+    }
+
+    std::vector<std::uint64_t> samples;
+    std::size_t visited = 0;
+    std::uint64_t start = nowNs();
+    for(auto &kv : map) {
+        (void)kv;
+        visited++;
+    }
+    std::uint64_t total = nowNs()-start;
+    report(backend, keyType, "iterate", loadFactor, visited, total,
+           samples);
+}
+
+struct Uint32KeyGen {
+    std::uint32_t operator()(std::size_t i) const {
+        // golden-ratio scramble so keys are not sequential
+        return std::uint32_t(i*2654435761u);
+    }
+};
+
+struct StringKeyGen {
+    std::string operator()(std::size_t i) const {
+        return "http://bench.example.com/path/segment/"+std::to_string(i);
+    }
+};
+
+int main(int argc, char **argv) {
+    std::size_t maxElem = 1000000;
+    if(argc>1) {
+        maxElem = std::strtoull(argv[1], nullptr, 10);
+    }
+
+    std::printf("backend,key,op,lf,n,mops,p50_ns,p99_ns\n");
+
+    // load factor trades memory for probe length, so it
+    // is a measured axis rather than a fixed constant
+    static const float loadFactors[] = {0.5f, 0.75f, 0.9f};
+
+    for(std::size_t n = 1000;n<=maxElem;n*=10) {
+        for(float lf : loadFactors) {
+            benchMap<HashMap<std::uint32_t, std::uint64_t>>(
+                    "chained", "uint32", n, Uint32KeyGen(), lf);
+            benchMap<OpenHashMap<std::uint32_t, std::uint64_t>>(
+                    "open", "uint32", n, Uint32KeyGen(), lf);
+            benchMap<HashMap<std::string, std::string>>(
+                    "chained", "string", n, StringKeyGen(), lf);
+            benchMap<OpenHashMap<std::string, std::string>>(
+                    "open", "string", n, StringKeyGen(), lf);
+        }
+        benchIterate<HashMap<std::uint32_t, std::uint64_t>>(
+                "chained", "uint32", n, Uint32KeyGen(), 0.75f);
+        benchIterate<HashMap<std::string, std::string>>(
+                "chained", "string", n, StringKeyGen(), 0.75f);
+    }
+
+    return 0;
+}
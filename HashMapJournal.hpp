@@ -0,0 +1,246 @@
+#ifndef HASH_MAP_JOURNAL
+#define HASH_MAP_JOURNAL
+
+#include "HashMap.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+/**
+ * Async write-behind persistence for @HashMap.
+ *
+ * @JournaledHashMap wraps a map and appends a compact
+ * binary record for every mutation to an in-memory
+ * double buffer; a background thread swaps the buffers
+ * and drains the full one to disk as a single large
+ * sequential write. The serving thread pays one short
+ * lock and a record copy per mutation instead of the
+ * seconds-long pause of snapshotting by full iteration.
+ * Reopening an existing journal replays it into the
+ * map first, so a new session serves every prior
+ * session's state and can journal erases of replayed
+ * keys; replay() streams a journal back into a plain
+ * @HashMap when the wrapper itself is not wanted.
+ *
+ * Like @HashMapSnapshot, keys and values must be
+ * trivially copyable and the format uses in-memory
+ * layout, portable only between builds with the same
+ * ABI. A crash can lose at most the records still in
+ * the buffers; call flush() at durability points.
+ */
+
+struct JournalHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t keySize;
+    std::uint32_t valueSize;
+};
+
+static const std::uint32_t JOURNAL_MAGIC = 0x484d4a4c; // "HMJL"
+static const std::uint32_t JOURNAL_VERSION = 1;
+
+enum JournalOp {
+    JOURNAL_PUT = 1,
+    JOURNAL_ERASE = 2,
+};
+
+template <typename K, typename V>
+struct JournalRecord {
+    static_assert(std::is_trivially_copyable<K>::value &&
+                  std::is_trivially_copyable<V>::value,
+                  "journaling requires trivially copyable keys and values");
+    std::uint8_t op;
+    K key;
+    V value;
+};
+
+template <typename K, typename V>
+class JournaledHashMap {
+public:
+    JournaledHashMap(const std::string &path,
+                     std::size_t bufferRecords = 4096):
+                                        m_bufferRecords(bufferRecords),
+                                        m_frontCount(0),
+                                        m_backCount(0),
+                                        m_stop(false)
+    {
+        m_front = new JournalRecord<K, V>[bufferRecords];
+        m_back = new JournalRecord<K, V>[bufferRecords];
+
+        // seed the map with earlier sessions' state so a
+        // reopened journal serves (and can erase) the keys
+        // it already holds; a fresh or unreadable file
+        // just leaves the map empty
+        replay(path, m_map);
+
+        // append mode keeps earlier sessions' records;
+        // a fresh file gets the header first
+        m_file = std::fopen(path.c_str(), "ab");
+        if(m_file && std::ftell(m_file) == 0) {
+            JournalHeader header;
+            header.magic = JOURNAL_MAGIC;
+            header.version = JOURNAL_VERSION;
+            header.keySize = sizeof(K);
+            header.valueSize = sizeof(V);
+            std::fwrite(&header, sizeof(header), 1, m_file);
+        }
+
+        m_drainer = std::thread(&JournaledHashMap::drainLoop, this);
+    }
+
+    JournaledHashMap(const JournaledHashMap&) = delete;
+    JournaledHashMap &operator=(const JournaledHashMap&) = delete;
+
+    ~JournaledHashMap() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_pending.notify_all();
+        m_drainer.join();
+        if(m_file) {
+            std::fclose(m_file);
+        }
+        delete [] m_front;
+        delete [] m_back;
+    }
+
+    void put(const K &k, V v) {
+        m_map[k] = std::move(v);
+        append(JOURNAL_PUT, k, m_map[k]);
+    }
+
+    bool erase(const K &k) {
+        if(!m_map.erase(k)) {
+            return false;
+        }
+        append(JOURNAL_ERASE, k, V());
+        return true;
+    }
+
+    V *find(const K &k) {
+        return m_map.find(k);
+    }
+
+    bool contains(const K &k) const {
+        return m_map.contains(k);
+    }
+
+    std::size_t size() const {
+        return m_map.size();
+    }
+
+    // blocks until every appended record has reached
+    // the file; the durability point for callers
+    void flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(m_frontCount || m_backCount) {
+            m_pending.notify_all();
+            m_drained.wait(lock);
+        }
+    }
+
+    /**
+     * @brief Streams a journal back into a @HashMap
+     *
+     * Replays puts and erases in order. A truncated
+     * trailing record (crash mid-write) is dropped;
+     * everything before it is reconstructed. Returns
+     * whether the journal was readable.
+     */
+    static bool replay(const std::string &path, HashMap<K, V> &out) {
+        std::FILE *f = std::fopen(path.c_str(), "rb");
+        if(!f) {
+            return false;
+        }
+
+        JournalHeader header;
+        if(std::fread(&header, sizeof(header), 1, f) != 1 ||
+                header.magic != JOURNAL_MAGIC ||
+                header.version != JOURNAL_VERSION ||
+                header.keySize != sizeof(K) ||
+                header.valueSize != sizeof(V)) {
+            std::fclose(f);
+            return false;
+        }
+
+        HashMap<K, V> map;
+        JournalRecord<K, V> rec;
+        while(std::fread(&rec, sizeof(rec), 1, f) == 1) {
+            if(rec.op == JOURNAL_PUT) {
+                map[rec.key] = rec.value;
+            } else if(rec.op == JOURNAL_ERASE) {
+                map.erase(rec.key);
+            }
+        }
+        std::fclose(f);
+        out = std::move(map);
+        return true;
+    }
+
+private:
+    void append(std::uint8_t op, const K &k, const V &v) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // backpressure: both buffers full means the disk
+        // cannot keep up; block rather than drop records
+        while(m_frontCount == m_bufferRecords) {
+            m_pending.notify_all();
+            m_drained.wait(lock);
+        }
+        JournalRecord<K, V> &rec = m_front[m_frontCount++];
+        rec.op = op;
+        rec.key = k;
+        rec.value = v;
+        if(m_frontCount >= m_bufferRecords/2) {
+            m_pending.notify_all();
+        }
+    }
+
+    void drainLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for(;;) {
+            while(!m_frontCount && !m_stop) {
+                m_pending.wait(lock);
+            }
+            if(!m_frontCount && m_stop) {
+                return;
+            }
+
+            // take the full buffer and write it out with
+            // the lock dropped so appends keep flowing
+            std::swap(m_front, m_back);
+            m_backCount = m_frontCount;
+            m_frontCount = 0;
+
+            lock.unlock();
+            if(m_file) {
+                std::fwrite(m_back, sizeof(JournalRecord<K, V>),
+                            m_backCount, m_file);
+                std::fflush(m_file);
+            }
+            lock.lock();
+
+            m_backCount = 0;
+            m_drained.notify_all();
+        }
+    }
+
+private:
+    HashMap<K, V> m_map;
+    std::FILE *m_file;
+    JournalRecord<K, V> *m_front;
+    JournalRecord<K, V> *m_back;
+    std::size_t m_bufferRecords;
+    std::size_t m_frontCount;
+    std::size_t m_backCount;
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_pending;
+    std::condition_variable m_drained;
+    std::thread m_drainer;
+};
+
+#endif // HASH_MAP_JOURNAL
@@ -0,0 +1,240 @@
+#ifndef HASH_MAP_SNAPSHOT
+#define HASH_MAP_SNAPSHOT
+
+#include "HashMap.hpp"
+
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Binary snapshot format for @HashMap.
+ *
+ * A snapshot is a header followed by a flat
+ * open-addressed slot image (hash, key, value,
+ * occupancy per slot). Because probing works
+ * directly on that layout, a snapshot can either
+ * be streamed back into a @HashMap or mmap()ed
+ * and served zero-copy through @MappedHashMap,
+ * where startup costs one mmap and lookups fault
+ * pages in on demand.
+ *
+ * Keys and values must be trivially copyable;
+ * the image uses in-memory layout and is only
+ * portable between builds with the same ABI.
+ */
+
+struct SnapshotHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t numSlots;
+    std::uint64_t numEntries;
+    std::uint32_t keySize;
+    std::uint32_t valueSize;
+};
+
+static const std::uint32_t SNAPSHOT_MAGIC = 0x484d5053; // "HMPS"
+static const std::uint32_t SNAPSHOT_VERSION = 1;
+
+template <typename K, typename V>
+struct SnapshotSlot {
+    static_assert(std::is_trivially_copyable<K>::value &&
+                  std::is_trivially_copyable<V>::value,
+                  "snapshots require trivially copyable keys and values");
+    std::uint64_t hash;
+    K key;
+    V value;
+    std::uint8_t occupied;
+};
+
+/**
+ * @brief Writes the map to path as a flat slot image
+ *
+ * Returns whether the write succeeded.
+ */
+template <typename K, typename V>
+bool saveHashMap(HashMap<K, V> &map, const std::string &path) {
+    std::size_t numSlots = roundUpPow2(map.size()*2);
+    std::size_t mask = numSlots-1;
+
+    SnapshotSlot<K, V> *slots = new SnapshotSlot<K, V>[numSlots]();
+    for(auto &kv : map) {
+        std::size_t i = kv.hash&mask;
+        while(slots[i].occupied) {
+            i = (i+1)&mask;
+        }
+        slots[i].hash = kv.hash;
+        slots[i].key = kv.key;
+        slots[i].value = kv.value;
+        slots[i].occupied = 1;
+    }
+
+    SnapshotHeader header;
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.numSlots = numSlots;
+    header.numEntries = map.size();
+    header.keySize = sizeof(K);
+    header.valueSize = sizeof(V);
+
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if(!f) {
+        delete [] slots;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(slots, sizeof(SnapshotSlot<K, V>),
+                          numSlots, f) == numSlots;
+    std::fclose(f);
+    delete [] slots;
+    return ok;
+}
+
+/**
+ * @brief Streams a snapshot back into a @HashMap
+ *
+ * Returns whether the load succeeded; on success
+ * out is replaced with the reconstructed map.
+ */
+template <typename K, typename V>
+bool loadHashMap(const std::string &path, HashMap<K, V> &out) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if(!f) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    if(std::fread(&header, sizeof(header), 1, f) != 1 ||
+            header.magic != SNAPSHOT_MAGIC ||
+            header.version != SNAPSHOT_VERSION ||
+            header.keySize != sizeof(K) ||
+            header.valueSize != sizeof(V)) {
+        std::fclose(f);
+        return false;
+    }
+
+    HashMap<K, V> map;
+    map.reserve(header.numEntries);
+    SnapshotSlot<K, V> slot;
+    for(std::uint64_t i = 0;i<header.numSlots;i++) {
+        if(std::fread(&slot, sizeof(slot), 1, f) != 1) {
+            std::fclose(f);
+            return false;
+        }
+        if(slot.occupied) {
+            map[slot.key] = slot.value;
+        }
+    }
+    std::fclose(f);
+    out = std::move(map);
+    return true;
+}
+
+/**
+ * @brief Read-only map view over an mmap()ed snapshot
+ *
+ * Probes the mapped slot image directly, so no
+ * entry is copied at load time; pages are faulted
+ * in as lookups touch them.
+ */
+template <typename K, typename V>
+class MappedHashMap {
+public:
+    MappedHashMap(const std::string &path): m_base(nullptr),
+                                            m_mapLen(0),
+                                            m_slots(nullptr),
+                                            m_numSlots(0),
+                                            m_numEntries(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd<0) {
+            return;
+        }
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0 ||
+                std::size_t(st.st_size)<sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return;
+        }
+
+        void *base = ::mmap(nullptr, st.st_size, PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED) {
+            return;
+        }
+
+        const SnapshotHeader *header =
+                static_cast<const SnapshotHeader*>(base);
+        if(header->magic != SNAPSHOT_MAGIC ||
+                header->version != SNAPSHOT_VERSION ||
+                header->keySize != sizeof(K) ||
+                header->valueSize != sizeof(V) ||
+                std::size_t(st.st_size) != sizeof(SnapshotHeader)+
+                    header->numSlots*sizeof(SnapshotSlot<K, V>)) {
+            ::munmap(base, st.st_size);
+            return;
+        }
+
+        m_base = base;
+        m_mapLen = st.st_size;
+        m_slots = reinterpret_cast<const SnapshotSlot<K, V>*>(
+                static_cast<const char*>(base)+sizeof(SnapshotHeader));
+        m_numSlots = header->numSlots;
+        m_numEntries = header->numEntries;
+    }
+
+    MappedHashMap(const MappedHashMap&) = delete;
+    MappedHashMap &operator=(const MappedHashMap&) = delete;
+
+    ~MappedHashMap() {
+        if(m_base) {
+            ::munmap(m_base, m_mapLen);
+        }
+    }
+
+    bool valid() const {
+        return m_slots != nullptr;
+    }
+
+    std::size_t size() const {
+        return m_numEntries;
+    }
+
+    const V *find(const K &k) const {
+        assert(m_slots);
+        std::uint64_t h = hash(k);
+        std::size_t mask = m_numSlots-1;
+        std::size_t i = h&mask;
+        for(std::size_t probe = 0;probe<m_numSlots;probe++) {
+            const SnapshotSlot<K, V> &s = m_slots[i];
+            if(!s.occupied) {
+                return nullptr;
+            }
+            if(s.hash == h && s.key == k) {
+                return &s.value;
+            }
+            i = (i+1)&mask;
+        }
+        return nullptr;
+    }
+
+    bool contains(const K &k) const {
+        return find(k) != nullptr;
+    }
+
+private:
+    void *m_base;
+    std::size_t m_mapLen;
+    const SnapshotSlot<K, V> *m_slots;
+    std::size_t m_numSlots;
+    std::size_t m_numEntries;
+};
+
+#endif // HASH_MAP_SNAPSHOT
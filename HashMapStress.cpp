@@ -0,0 +1,220 @@
+#include "HashMap.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Stress harness for HashMap hash quality.
+ *
+ * Drives the chained backend with sequential, uniform
+ * random, Zipfian and adversarial (all keys forced
+ * into one bucket by inverting the hash finalizer)
+ * key distributions, compares the achieved
+ * chain-length distribution against the Poisson ideal
+ * for the measured load, and reports the throughput
+ * of each pattern relative to the uniform baseline.
+ *
+ * Exits nonzero when distribution quality regresses
+ * on the non-adversarial patterns, so a hash-function
+ * change that merely looks unique on small samples
+ * but clusters under real traffic fails the build.
+ *
+ * Usage: HashMapStress [numKeys]   (make stress)
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile std::size_t g_sink;
+
+static std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+}
+
+// inverse of hashFinalize(); lets the adversarial
+// pattern construct keys whose final hash lands in
+// whichever bucket it likes
+static std::uint64_t hashFinalizeInverse(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0x9cb4b2f8129337dbull;     // modular inverse of 0xc4ceb9fe1a85ec53
+    h ^= h >> 33;
+    h *= 0x4f74430c22a54005ull;     // modular inverse of 0xff51afd7ed558ccd
+    h ^= h >> 33;
+    return h;
+}
+
+struct RunResult {
+    const char *name;
+    std::size_t distinct;
+    double insertMops;
+    double lookupMops;
+    double avgProbe;        // compares per lookup, hits only
+    std::uint64_t maxProbe;
+    HashMapStats stats;
+    std::size_t capacity;
+};
+
+static RunResult run(const char *name,
+                     const std::vector<std::uint64_t> &keys) {
+    InstrumentedHashMap<std::uint64_t, std::uint64_t> map;
+    RunResult r = {};
+    r.name = name;
+
+    std::uint64_t start = nowNs();
+    for(std::size_t i = 0;i<keys.size();i++) {
+        map[keys[i]] = i;
+    }
+    std::uint64_t insertNs = nowNs()-start;
+
+    HashMapStats afterInsert = map.stats();
+
+    start = nowNs();
+    for(std::size_t i = 0;i<keys.size();i++) {
+        g_sink += map.find(keys[i]) != nullptr;
+    }
+    std::uint64_t lookupNs = nowNs()-start;
+
+    r.stats = map.stats();
+    r.distinct = map.size();
+    r.capacity = map.capacity();
+    r.insertMops = insertNs ? (double)keys.size()*1e3/insertNs : 0;
+    r.lookupMops = lookupNs ? (double)keys.size()*1e3/lookupNs : 0;
+    std::uint64_t lookups = r.stats.lookups-afterInsert.lookups;
+    r.avgProbe = lookups ?
+            (double)(r.stats.probes-afterInsert.probes)/lookups : 0;
+    r.maxProbe = r.stats.maxProbe;
+    return r;
+}
+
+// Poisson pmf summed over the histogram bin covering
+// [lo, hi]; the ideal share of buckets with that many
+// entries under a perfectly uniform hash
+static double poissonBin(double lambda, std::size_t lo, std::size_t hi) {
+    double p = 0;
+    for(std::size_t k = lo;k<=hi;k++) {
+        p += std::exp(-lambda+k*std::log(lambda)-std::lgamma(k+1));
+    }
+    return p;
+}
+
+static void reportChains(const RunResult &r) {
+    static const std::size_t binLo[] = {0, 1, 2, 3, 4, 8, 16, 32};
+    static const std::size_t binHi[] = {0, 1, 2, 3, 7, 15, 31, 4096};
+    double lambda = (double)r.distinct/r.capacity;
+
+    std::printf("  chain length   measured    poisson ideal\n");
+    for(std::size_t b = 0;b<HashMapStats::CHAIN_HIST;b++) {
+        std::printf("  %4zu-%-4zu      %-10.5f  %.5f\n",
+                    binLo[b], binHi[b],
+                    (double)r.stats.chainHist[b]/r.capacity,
+                    poissonBin(lambda, binLo[b], binHi[b]));
+    }
+}
+
+int main(int argc, char **argv) {
+    std::size_t numKeys = 200000;
+    if(argc>1) {
+        numKeys = std::strtoull(argv[1], nullptr, 10);
+    }
+
+    std::mt19937_64 rng(42);
+    std::vector<std::uint64_t> keys(numKeys);
+
+    // sequential: what the unit tests use, and what the
+    // old golden-ratio int hash handled worst
+    for(std::size_t i = 0;i<numKeys;i++) {
+        keys[i] = i;
+    }
+    RunResult seq = run("sequential", keys);
+
+    for(std::size_t i = 0;i<numKeys;i++) {
+        keys[i] = rng();
+    }
+    RunResult uniform = run("uniform", keys);
+
+    // Zipfian over numKeys/10 distinct keys, skew 1.0 —
+    // a stand-in for production traffic where a few
+    // keys absorb most of the accesses
+    {
+        std::size_t distinct = numKeys/10;
+        std::vector<double> cdf(distinct);
+        double sum = 0;
+        for(std::size_t i = 0;i<distinct;i++) {
+            sum += 1.0/(i+1);
+            cdf[i] = sum;
+        }
+        std::uniform_real_distribution<double> u(0, sum);
+        for(std::size_t i = 0;i<numKeys;i++) {
+            double x = u(rng);
+            keys[i] = std::lower_bound(cdf.begin(), cdf.end(), x)-
+                    cdf.begin();
+        }
+    }
+    RunResult zipf = run("zipfian", keys);
+
+    // adversarial: invert the finalizer so every key
+    // hashes to a multiple of 2^20 — one bucket takes
+    // the entire key set at any capacity up to 2^20.
+    // Uses fewer keys; chains this long are quadratic
+    std::size_t advKeys = std::min<std::size_t>(numKeys, 20000);
+    keys.resize(advKeys);
+    for(std::size_t i = 0;i<advKeys;i++) {
+        keys[i] = hashFinalizeInverse((std::uint64_t(i)+1)<<20);
+    }
+    RunResult adv = run("adversarial", keys);
+
+    RunResult runs[] = {seq, uniform, zipf, adv};
+    std::printf("distribution  distinct  insert_mops  lookup_mops"
+                "  vs_uniform  avg_probe  max_probe\n");
+    for(const RunResult &r : runs) {
+        std::printf("%-12s  %-8zu  %-11.3f  %-11.3f  %-10.3f"
+                    "  %-9.3f  %zu\n",
+                    r.name, r.distinct, r.insertMops, r.lookupMops,
+                    uniform.lookupMops ?
+                            r.lookupMops/uniform.lookupMops : 0,
+                    r.avgProbe, std::size_t(r.maxProbe));
+    }
+
+    for(const RunResult &r : {seq, uniform, zipf}) {
+        std::printf("\n%s vs Poisson (load %.3f):\n", r.name,
+                    (double)r.distinct/r.capacity);
+        reportChains(r);
+    }
+
+    // quality gates: on well-behaved input a healthy
+    // hash stays near the Poisson ideal. An average
+    // hit needs ~1+load/2 compares; 2.0 leaves slack.
+    // Chains of 8+ should essentially not exist
+    int failures = 0;
+    for(const RunResult &r : {seq, uniform, zipf}) {
+        double longChains = 0;
+        for(std::size_t b = 5;b<HashMapStats::CHAIN_HIST;b++) {
+            longChains += r.stats.chainHist[b];
+        }
+        longChains /= r.capacity;
+        bool ok = r.avgProbe<=2.0 && longChains<=0.002;
+        std::printf("%s: avg_probe %.3f (<=2.0), chains>=8 %.4f%%"
+                    " (<=0.2%%) %s\n",
+                    r.name, r.avgProbe, longChains*100,
+                    ok ? "PASS" : "FAIL");
+        if(!ok) {
+            failures++;
+        }
+    }
+
+    // the adversarial pattern is expected to cluster;
+    // gate correctness only
+    bool advOk = adv.distinct == advKeys;
+    std::printf("adversarial: %zu/%zu keys retrievable %s\n",
+                adv.distinct, advKeys, advOk ? "PASS" : "FAIL");
+    if(!advOk) {
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,13 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "HashMap.hpp"
+#include "ConcurrentHashMap.hpp"
+#include "HashMapSnapshot.hpp"
+#include "StaticHashMap.hpp"
+#include "HashMapJournal.hpp"
 #include <vector>
+#include <thread>
+#include <atomic>
 
 
 TEST_CASE( "LinkedList Test", "[LinkedList]") {
@@ -34,6 +40,126 @@ TEST_CASE( "LinkedList Test", "[LinkedList]") {
 
         list.clear();
         REQUIRE (list.size() == 0);
+
+        // removing the head promotes the first overflow
+        // node into the inline slot
+        list.pushBack(1);
+        list.pushBack(2);
+        list.pushBack(3);
+        list.remove(list.head());
+        REQUIRE( list.size() == 2 );
+        REQUIRE( list[0] == 2 );
+        REQUIRE( list[1] == 3 );
+        REQUIRE( list.tail() == 3 );
+        list.remove(list.head());
+        list.remove(list.head());
+        REQUIRE( list.size() == 0 );
+
+        // arena slabs must keep over-aligned value types
+        // as aligned as per-node new would
+        struct alignas(16) Wide {
+            double d[2];
+        };
+        NodeArena<ListItem<Wide>> arena;
+        LinkedList<Wide> wide;
+        wide.setArena(&arena);
+        for(int i = 0;i<100;i++) {
+            wide.pushBack(Wide());
+        }
+        int misaligned = 0;
+        for(ListItem<Wide> *i = wide.head(); i; i = i->next) {
+            if(reinterpret_cast<std::uintptr_t>(i)%alignof(Wide)) {
+                misaligned++;
+            }
+        }
+        CHECK( misaligned == 0 );
+    }
+}
+
+TEST_CASE("ConcurrentHashMap Test", "[ConcurrentHashMap]") {
+    SECTION("Parallel insert/lookup Test") {
+        ConcurrentHashMap<std::string, std::string> dict;
+
+        const int numThreads = 4;
+        const int perThread = 1000;
+
+        std::vector<std::thread> threads;
+        for(int t = 0;t<numThreads;t++) {
+            threads.emplace_back([&dict, t]() {
+                for(int i = 0;i<perThread;i++) {
+                    int n = t*perThread+i;
+                    dict.put("key"+std::to_string(n),
+                             "value"+std::to_string(n));
+                }
+            });
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        REQUIRE( dict.size() == numThreads*perThread );
+
+        int err = 0;
+        for(int i = 0;i<numThreads*perThread;i++) {
+            std::string v;
+            if(!dict.tryGet("key"+std::to_string(i), v) ||
+                    v != "value"+std::to_string(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        REQUIRE( dict.erase("key0") );
+        REQUIRE( !dict.contains("key0") );
+        REQUIRE( dict.size() == numThreads*perThread-1 );
+    }
+
+    SECTION("ReadMostlyHashMap Test") {
+        ReadMostlyHashMap<std::string, std::string> dict(64);
+
+        const int numKeys = 100;
+        for(int i = 0;i<numKeys;i++) {
+            dict.put("key"+std::to_string(i), "value"+std::to_string(i));
+        }
+        REQUIRE( dict.size() == numKeys );
+
+        // overwrite must not grow the map
+        dict.put("key0", "updated");
+        REQUIRE( dict.size() == numKeys );
+        std::string v;
+        REQUIRE( dict.tryGet("key0", v) );
+        REQUIRE( v == "updated" );
+
+        REQUIRE( dict.erase("key1") );
+        REQUIRE( !dict.contains("key1") );
+        REQUIRE( dict.size() == numKeys-1 );
+
+        // readers race with a writer that keeps
+        // updating and erasing the same keys
+        std::atomic<bool> stop(false);
+        std::atomic<int> readErrs(0);
+        std::vector<std::thread> readers;
+        for(int t = 0;t<3;t++) {
+            readers.emplace_back([&dict, &stop, &readErrs]() {
+                std::string out;
+                while(!stop.load()) {
+                    if(dict.tryGet("key2", out) && out.empty()) {
+                        readErrs++;
+                    }
+                    dict.contains("key3");
+                }
+            });
+        }
+        for(int i = 0;i<2000;i++) {
+            dict.put("key2", "value"+std::to_string(i));
+            dict.erase("key3");
+            dict.put("key3", "value"+std::to_string(i));
+        }
+        stop = true;
+        for(auto &t : readers) {
+            t.join();
+        }
+        CHECK( readErrs == 0 );
     }
 }
 
@@ -58,7 +184,7 @@ TEST_CASE("HashMap Test", "[HashMap]") {
         }
         CHECK( err == 0 );
 
-        // test hash for std::int32_t
+        // test hash for integer types
         hashes.clear();
         err = 0;
         for(int i = 0;i<numHashes;i++) {
@@ -70,6 +196,21 @@ TEST_CASE("HashMap Test", "[HashMap]") {
         }
         CHECK( err == 0);
 
+        // 64-bit and pointer keys
+        HashMap<std::uint64_t, int> bigKeys;
+        for(std::uint64_t i = 0;i<1000;i++) {
+            bigKeys[i<<40] = int(i);
+        }
+        REQUIRE( bigKeys.size() == 1000 );
+        REQUIRE( bigKeys[std::uint64_t(42)<<40] == 42 );
+
+        int objects[4];
+        HashMap<int*, int> ptrKeys;
+        for(int i = 0;i<4;i++) {
+            ptrKeys[&objects[i]] = i;
+        }
+        REQUIRE( ptrKeys.size() == 4 );
+        REQUIRE( ptrKeys[&objects[2]] == 2 );
     }
 
     SECTION("HashMap Test") {
@@ -94,6 +235,682 @@ TEST_CASE("HashMap Test", "[HashMap]") {
         REQUIRE( got.size() == expected.size() );
     }
 
+    SECTION("find()/contains()/emplace() Test") {
+        HashMap<std::string, std::string> dict;
+
+        REQUIRE( dict.find("missing") == nullptr );
+        REQUIRE( !dict.contains("missing") );
+        REQUIRE( dict.size() == 0 );
+
+        dict.emplace("a", "1");
+        dict.emplace("a", "2");
+        REQUIRE( dict.size() == 1 );
+        REQUIRE( dict["a"] == "1" );
+
+        REQUIRE( dict.contains("a") );
+        std::string *v = dict.find("a");
+        REQUIRE( v != nullptr );
+        REQUIRE( *v == "1" );
+
+        OpenHashMap<std::string, std::string> flat;
+        REQUIRE( flat.find("missing") == nullptr );
+        flat.emplace("a", "1");
+        REQUIRE( flat.contains("a") );
+        REQUIRE( flat["a"] == "1" );
+    }
+
+    SECTION("reserve()/bulk insert Test") {
+        std::vector<KeyVal<std::string, std::string>> entries;
+        const int numElem = 1000;
+        for(int i = 0;i<numElem;i++) {
+            entries.push_back(KeyVal<std::string, std::string>(
+                    "key"+std::to_string(i), "value"+std::to_string(i)));
+        }
+
+        HashMap<std::string, std::string> dict(entries.begin(), entries.end());
+        REQUIRE( dict.size() == numElem );
+        REQUIRE( dict.capacity()>=numElem );
+        REQUIRE( dict["key123"] == "value123" );
+
+        HashMap<std::string, std::string> reserved;
+        reserved.reserve(numElem);
+        std::size_t cap = reserved.capacity();
+        reserved.insert(entries.begin(), entries.end());
+        REQUIRE( reserved.capacity() == cap );
+        REQUIRE( reserved.size() == numElem );
+    }
+
+    SECTION("erase() Test") {
+        HashMap<std::string, std::string> dict;
+        const int numElem = 1000;
+        for(int i = 0;i<numElem;i++) {
+            dict["key"+std::to_string(i)] = "value"+std::to_string(i);
+        }
+
+        REQUIRE( !dict.erase("missing") );
+        REQUIRE( dict.size() == numElem );
+
+        int err = 0;
+        for(int i = 0;i<numElem;i+=2) {
+            if(!dict.erase("key"+std::to_string(i))) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+        REQUIRE( dict.size() == numElem/2 );
+
+        err = 0;
+        for(int i = 0;i<numElem;i++) {
+            bool present = dict.contains("key"+std::to_string(i));
+            if(present != (i%2 == 1)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        OpenHashMap<std::string, std::string> flat;
+        for(int i = 0;i<numElem;i++) {
+            flat["key"+std::to_string(i)] = "value"+std::to_string(i);
+        }
+        REQUIRE( flat.erase("key10") );
+        REQUIRE( !flat.erase("key10") );
+        REQUIRE( !flat.contains("key10") );
+        REQUIRE( flat.contains("key11") );
+        REQUIRE( flat.size() == numElem-1 );
+
+        // regression: erasing keys while a migration is in
+        // flight. find() relocates the entry into the new
+        // pool; if the old copy were left behind, erase()
+        // would remove only one of them and migrating the
+        // old bucket would resurrect the erased key
+        HashMap<std::uint64_t, std::uint64_t> big;
+        const std::uint64_t bigElem = 6200;  // 8192->16384 rehash in flight
+        for(std::uint64_t i = 0;i<bigElem;i++) {
+            big[i] = i;
+        }
+        err = 0;
+        for(std::uint64_t i = 0;i<100;i++) {
+            if(!big.find(i) || !big.erase(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+        std::size_t visited = 0;
+        for(auto &kv : big) {   // begin() drains the old pool
+            (void)kv;
+            visited++;
+        }
+        REQUIRE( big.size() == bigElem-100 );
+        REQUIRE( visited == bigElem-100 );
+        err = 0;
+        for(std::uint64_t i = 0;i<100;i++) {
+            if(big.contains(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+    }
+
+    SECTION("Snapshot save/load Test") {
+        const char *path = "test_snapshot.bin";
+        const int numElem = 1000;
+
+        HashMap<std::uint32_t, std::uint64_t> map;
+        for(std::uint32_t i = 0;i<numElem;i++) {
+            map[i] = std::uint64_t(i)*3;
+        }
+
+        REQUIRE( saveHashMap(map, path) );
+
+        HashMap<std::uint32_t, std::uint64_t> loaded;
+        REQUIRE( loadHashMap(path, loaded) );
+        REQUIRE( loaded.size() == numElem );
+        REQUIRE( loaded[123] == 369 );
+
+        MappedHashMap<std::uint32_t, std::uint64_t> mapped(path);
+        REQUIRE( mapped.valid() );
+        REQUIRE( mapped.size() == numElem );
+        int err = 0;
+        for(std::uint32_t i = 0;i<numElem;i++) {
+            const std::uint64_t *v = mapped.find(i);
+            if(!v || *v != std::uint64_t(i)*3) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+        REQUIRE( mapped.find(numElem+1) == nullptr );
+
+        std::remove(path);
+    }
+
+    SECTION("getMany() Test") {
+        HashMap<std::uint32_t, std::uint64_t> map;
+        const int numElem = 1000;
+        for(std::uint32_t i = 0;i<numElem;i++) {
+            map[i] = std::uint64_t(i)+7;
+        }
+
+        std::vector<std::uint32_t> keys;
+        for(std::uint32_t i = 0;i<numElem*2;i++) {
+            keys.push_back(i);
+        }
+        std::vector<std::uint64_t*> out(keys.size());
+
+        map.getMany(keys.data(), keys.size(), out.data());
+
+        int err = 0;
+        for(std::size_t i = 0;i<keys.size();i++) {
+            if(i<numElem) {
+                if(!out[i] || *out[i] != std::uint64_t(i)+7) {
+                    err++;
+                }
+            } else if(out[i]) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        OpenHashMap<std::uint32_t, std::uint64_t> flat;
+        for(std::uint32_t i = 0;i<numElem;i++) {
+            flat[i] = std::uint64_t(i)+7;
+        }
+        flat.getMany(keys.data(), keys.size(), out.data());
+        err = 0;
+        for(std::size_t i = 0;i<keys.size();i++) {
+            if(i<numElem) {
+                if(!out[i] || *out[i] != std::uint64_t(i)+7) {
+                    err++;
+                }
+            } else if(out[i]) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+    }
+
+    SECTION("Move semantics Test") {
+        HashMap<std::string, std::string> src;
+        const int numElem = 100;
+        for(int i = 0;i<numElem;i++) {
+            src["key"+std::to_string(i)] = "value"+std::to_string(i);
+        }
+
+        HashMap<std::string, std::string> dst(std::move(src));
+        REQUIRE( dst.size() == numElem );
+        REQUIRE( dst["key42"] == "value42" );
+
+        HashMap<std::string, std::string> assigned;
+        assigned = std::move(dst);
+        REQUIRE( assigned.size() == numElem );
+        REQUIRE( assigned["key42"] == "value42" );
+
+        OpenHashMap<std::string, std::string> flatSrc;
+        for(int i = 0;i<numElem;i++) {
+            flatSrc["key"+std::to_string(i)] = "value"+std::to_string(i);
+        }
+        OpenHashMap<std::string, std::string> flatDst(std::move(flatSrc));
+        REQUIRE( flatDst.size() == numElem );
+        REQUIRE( flatDst["key42"] == "value42" );
+    }
+
+    SECTION("OpenHashMap Test") {
+        OpenHashMap<std::string, std::string> dict;
+
+        REQUIRE( dict.size() == 0 );
+        REQUIRE( dict.capacity()>0 );
+
+        const int numElem = 1000;
+
+        for(int i = 0;i<numElem;i++) {
+            dict["key"+std::to_string(i)] = "value"+std::to_string(i);
+        }
+
+        REQUIRE( dict.size() == numElem );
+
+        int err = 0;
+        for(int i = 0;i<numElem;i++) {
+            if(dict["key"+std::to_string(i)] != "value"+std::to_string(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        // steady insert/erase churn: tombstone pressure is
+        // relieved by rehashing in place, so a table whose
+        // live count never grows must not grow either
+        OpenHashMap<int, int> churn(2048);
+        std::size_t cap = churn.capacity();
+        for(int round = 0;round<50;round++) {
+            for(int i = 0;i<1000;i++) {
+                churn[round*1000+i] = i;
+            }
+            for(int i = 0;i<1000;i++) {
+                churn.erase(round*1000+i);
+            }
+        }
+        REQUIRE( churn.size() == 0 );
+        REQUIRE( churn.capacity() == cap );
+        churn[7] = 7;
+        REQUIRE( churn.contains(7) );
+    }
+
+    SECTION("Journal write-behind Test") {
+        const std::string path = "/tmp/hashmap_journal_test.bin";
+        std::remove(path.c_str());
+
+        {
+            JournaledHashMap<std::uint32_t, std::uint64_t> dict(path);
+
+            const int numElem = 1000;
+            for(int i = 0;i<numElem;i++) {
+                dict.put(i, std::uint64_t(i)*10);
+            }
+            for(int i = 0;i<100;i++) {
+                dict.erase(i);
+            }
+            dict.put(0, 42);
+            REQUIRE( dict.size() == numElem-100+1 );
+            REQUIRE( *dict.find(0) == 42 );
+
+            dict.flush();
+        }   // destructor drains whatever flush missed
+
+        HashMap<std::uint32_t, std::uint64_t> replayed;
+        REQUIRE( JournaledHashMap<std::uint32_t,
+                std::uint64_t>::replay(path, replayed) );
+        REQUIRE( replayed.size() == 901 );
+        REQUIRE( replayed[0] == 42 );
+        REQUIRE( !replayed.contains(50) );
+        int err = 0;
+        for(int i = 100;i<1000;i++) {
+            if(replayed[i] != std::uint64_t(i)*10) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        // reopening replays the prior session, so the new
+        // session serves old keys and can erase them
+        {
+            JournaledHashMap<std::uint32_t, std::uint64_t> dict(path);
+            REQUIRE( dict.size() == 901 );
+            REQUIRE( dict.find(200) != nullptr );
+            REQUIRE( *dict.find(200) == 2000 );
+            REQUIRE( dict.erase(200) );
+            dict.put(5000, 1);
+        }
+        HashMap<std::uint32_t, std::uint64_t> again;
+        REQUIRE( JournaledHashMap<std::uint32_t,
+                std::uint64_t>::replay(path, again) );
+        REQUIRE( again.size() == 901 );
+        REQUIRE( again[5000] == 1 );
+        // the erase of a session-one key was journaled;
+        // replay must not resurrect it
+        REQUIRE( !again.contains(200) );
+
+        std::remove(path.c_str());
+    }
+
+    SECTION("insertBatch() Test") {
+        HashMap<std::string, std::string> dict;
+        dict["key0"] = "already";
+
+        std::vector<KeyVal<std::string, std::string>> batch;
+        const int numElem = 5000;
+        for(int i = 0;i<numElem;i++) {
+            batch.push_back(KeyVal<std::string, std::string>(
+                    "key"+std::to_string(i), "value"+std::to_string(i)));
+        }
+
+        dict.insertBatch(batch.data(), batch.size());
+
+        REQUIRE( dict.size() == numElem );
+        REQUIRE( dict["key0"] == "already" );   // existing key kept
+        REQUIRE( dict.capacity()>=numElem );
+        int err = 0;
+        for(int i = 1;i<numElem;i++) {
+            if(dict["key"+std::to_string(i)] != "value"+std::to_string(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        // a batch small enough stays inline
+        HashMap<std::string, std::string> tiny;
+        tiny.insertBatch(batch.data(), 4);
+        REQUIRE( tiny.size() == 4 );
+        REQUIRE( tiny.capacity() == 8 );
+        REQUIRE( tiny["key2"] == "value2" );
+
+        // capped maps keep eviction semantics
+        LruHashMap<std::string, std::string> cache(16, 0.75, 100);
+        cache.insertBatch(batch.data(), batch.size());
+        REQUIRE( cache.size() == 100 );
+    }
+
+    SECTION("SoAHashMap Test") {
+        // large values are exactly what the split
+        // key/value arrays are for
+        struct Payload {
+            char blob[256];
+        };
+
+        SoAHashMap<std::uint32_t, Payload> dict;
+
+        const int numElem = 1000;
+        for(int i = 0;i<numElem;i++) {
+            Payload p = {};
+            p.blob[0] = char(i&0x7f);
+            dict[std::uint32_t(i)] = p;
+        }
+        REQUIRE( dict.size() == numElem );
+        REQUIRE( dict.find(42u) != nullptr );
+        REQUIRE( dict.find(42u)->blob[0] == 42 );
+        REQUIRE( dict.find(std::uint32_t(numElem)) == nullptr );
+
+        // key sweep without touching values
+        std::uint64_t sum = 0;
+        dict.forEachKey([&sum](const std::uint32_t &k) {
+            sum += k;
+        });
+        REQUIRE( sum == std::uint64_t(numElem)*(numElem-1)/2 );
+
+        REQUIRE( dict.erase(42u) );
+        REQUIRE( !dict.contains(42u) );
+        REQUIRE( dict.size() == numElem-1 );
+
+        int visited = 0;
+        dict.forEach([&visited](const std::uint32_t&, const Payload&) {
+            visited++;
+        });
+        REQUIRE( visited == numElem-1 );
+
+        // churn must rehash tombstones away in place
+        // instead of growing (same as the open backend)
+        SoAHashMap<int, int> churn(2048);
+        std::size_t cap = churn.capacity();
+        for(int round = 0;round<50;round++) {
+            for(int i = 0;i<1000;i++) {
+                churn[round*1000+i] = i;
+            }
+            for(int i = 0;i<1000;i++) {
+                churn.erase(round*1000+i);
+            }
+        }
+        REQUIRE( churn.size() == 0 );
+        REQUIRE( churn.capacity() == cap );
+    }
+
+    SECTION("LRU eviction Test") {
+        // the recency links only exist on LruHashMap;
+        // plain map nodes stay two pointers smaller
+        REQUIRE( sizeof(ListItem<int>) < sizeof(ListItem<int, true>) );
+
+        LruHashMap<std::string, int> cache(16, 0.75, 3);
+
+        cache["a"] = 1;
+        cache["b"] = 2;
+        cache["c"] = 3;
+        REQUIRE( cache.size() == 3 );
+        std::size_t cap = cache.capacity();
+
+        // touching "a" makes "b" the coldest entry
+        REQUIRE( cache.find("a") != nullptr );
+        cache["d"] = 4;
+        REQUIRE( cache.size() == 3 );
+        REQUIRE( !cache.contains("b") );
+        REQUIRE( cache.contains("a") );
+        REQUIRE( cache.contains("c") );
+        REQUIRE( cache.contains("d") );
+
+        // accessing an existing key neither grows nor evicts
+        cache["d"] = 40;
+        REQUIRE( cache.size() == 3 );
+        REQUIRE( cache.contains("a") );
+
+        cache["e"] = 5;
+        REQUIRE( !cache.contains("c") );
+
+        // the table never rehashes past its cap
+        REQUIRE( cache.capacity() == cap );
+
+        REQUIRE( cache.erase("a") );
+        REQUIRE( cache.size() == 2 );
+
+        // with no lookups in between eviction is FIFO:
+        // only the newest maxEntries keys survive
+        LruHashMap<int, int> big(16, 0.75, 100);
+        for(int i = 0;i<1000;i++) {
+            big[i] = i;
+        }
+        REQUIRE( big.size() == 100 );
+        int err = 0;
+        for(int i = 900;i<1000;i++) {
+            if(!big.contains(i)) {
+                err++;
+            }
+        }
+        for(int i = 0;i<900;i++) {
+            if(big.contains(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+    }
+
+    SECTION("Instrumentation Test") {
+        InstrumentedHashMap<std::string, int> dict;
+
+        const int numElem = 1000;
+        for(int i = 0;i<numElem;i++) {
+            dict["key"+std::to_string(i)] = i;
+        }
+        for(int i = 0;i<numElem;i++) {
+            dict.find("key"+std::to_string(i));
+        }
+        dict.find("missing");
+        dict.erase("key0");
+
+        HashMapStats s = dict.stats();
+        REQUIRE( s.inserts == numElem );
+        REQUIRE( s.erases == 1 );
+        REQUIRE( s.lookups>0 );
+        // misses on empty buckets walk zero entries, so
+        // probes may trail lookups — but the hit loop
+        // above guarantees at least one compare each
+        REQUIRE( s.probes>=std::uint64_t(numElem) );
+        REQUIRE( s.maxProbe>=1 );
+        REQUIRE( s.rehashes>0 );
+
+        // histogram covers every bucket exactly once
+        std::uint64_t buckets = 0;
+        for(std::size_t i = 0;i<HashMapStats::CHAIN_HIST;i++) {
+            buckets += s.chainHist[i];
+        }
+        REQUIRE( buckets == dict.capacity() );
+
+        // the uninstrumented default still compiles and
+        // carries no stats() member
+        HashMap<std::string, int> plain;
+        plain["a"] = 1;
+        REQUIRE( plain["a"] == 1 );
+    }
+
+    SECTION("buildParallel() Test") {
+        std::vector<KeyVal<std::string, std::string>> entries;
+        const int numElem = 20000;
+        for(int i = 0;i<numElem;i++) {
+            entries.push_back(KeyVal<std::string, std::string>(
+                    "key"+std::to_string(i), "value"+std::to_string(i)));
+        }
+        // a duplicate key must not inflate the size
+        entries.push_back(KeyVal<std::string, std::string>(
+                "key0", "other"));
+
+        auto dict = HashMap<std::string, std::string>::buildParallel(
+                entries.begin(), entries.end(), 4);
+
+        REQUIRE( dict.size() == numElem );
+        REQUIRE( dict["key0"] == "value0" );    // first occurrence wins
+        int err = 0;
+        for(int i = 0;i<numElem;i++) {
+            if(dict["key"+std::to_string(i)] != "value"+std::to_string(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        // the built map behaves like any other
+        REQUIRE( dict.erase("key5") );
+        REQUIRE( !dict.contains("key5") );
+        dict["newkey"] = "newvalue";
+        REQUIRE( dict.size() == numElem );
+
+        // small ranges take the sequential path
+        auto tiny = HashMap<std::string, std::string>::buildParallel(
+                entries.begin(), entries.begin()+10, 4);
+        REQUIRE( tiny.size() == 10 );
+        REQUIRE( tiny["key3"] == "value3" );
+    }
+
+    SECTION("shrinkToFit() Test") {
+        HashMap<int, int> dict;
+        const int numElem = 10000;
+        for(int i = 0;i<numElem;i++) {
+            dict[i] = i;
+        }
+        std::size_t peak = dict.capacity();
+
+        // a purge leaves the peak-size bucket array in
+        // place until something shrinks it
+        for(int i = 100;i<numElem;i++) {
+            dict.erase(i);
+        }
+        REQUIRE( dict.size() == 100 );
+        REQUIRE( dict.capacity()<peak );    // erase-driven shrink kicked in
+
+        dict.shrinkToFit();
+        REQUIRE( dict.capacity()<=256 );
+        int err = 0;
+        for(int i = 0;i<100;i++) {
+            if(!dict.contains(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+
+        // small enough maps drop back to inline storage
+        for(int i = 4;i<100;i++) {
+            dict.erase(i);
+        }
+        dict.shrinkToFit();
+        REQUIRE( dict.capacity() == 8 );
+        REQUIRE( dict.size() == 4 );
+        REQUIRE( dict[2] == 2 );
+
+        OpenHashMap<int, int> flat;
+        for(int i = 0;i<numElem;i++) {
+            flat[i] = i;
+        }
+        std::size_t flatPeak = flat.capacity();
+        for(int i = 10;i<numElem;i++) {
+            flat.erase(i);
+        }
+        flat.shrinkToFit();
+        REQUIRE( flat.capacity()<flatPeak );
+        REQUIRE( flat[5] == 5 );
+    }
+
+    SECTION("StaticHashMap Test") {
+        static constexpr StaticEntry<int> opcodes[] = {
+            {"GET", 1}, {"PUT", 2}, {"DEL", 3},
+            {"SCAN", 4}, {"PING", 5}, {"STAT", 6},
+        };
+        static constexpr auto table = makeStaticHashMap(opcodes);
+
+        // the table is built (and its seed searched)
+        // entirely at compile time
+        static_assert(table.size() == 6, "six opcodes");
+        static_assert(*table.find("PUT") == 2, "compile-time lookup");
+        static_assert(!table.contains("NOPE"), "compile-time miss");
+
+        REQUIRE( table.find("GET") != nullptr );
+        REQUIRE( *table.find("STAT") == 6 );
+        REQUIRE( *table.find(std::string("SCAN")) == 4 );
+        REQUIRE( table.find("PONG") == nullptr );
+        REQUIRE( table.capacity() == 16 );
+    }
+
+    SECTION("Heterogeneous lookup Test") {
+        HashMap<std::string, int> dict;
+
+        for(int i = 0;i<100;i++) {
+            dict["key"+std::to_string(i)] = i;
+        }
+
+        // a StringRef over a larger buffer probes
+        // without building a std::string key
+        char buf[] = "key42trailinggarbage";
+        REQUIRE( hash(StringRef(buf, 5)) == hash(std::string("key42")) );
+        REQUIRE( dict.find(StringRef(buf, 5)) != nullptr );
+        REQUIRE( *dict.find(StringRef(buf, 5)) == 42 );
+
+        // C strings hash their bytes, not their address
+        REQUIRE( dict.contains("key7") );
+        REQUIRE( dict.find("nokey") == nullptr );
+
+        REQUIRE( dict.erase(StringRef("key13")) );
+        REQUIRE( !dict.contains("key13") );
+        REQUIRE( dict.size() == 99 );
+
+        OpenHashMap<std::string, int> open;
+        open["alpha"] = 1;
+        REQUIRE( open.contains(StringRef("alpha")) );
+        REQUIRE( open.find("beta") == nullptr );
+    }
+
+    SECTION("Inline small map Test") {
+        HashMap<std::string, int> dict;
+
+        // tiny maps hold entries inline and report the
+        // inline capacity until they spill
+        const std::size_t inlineCap = dict.capacity();
+
+        for(std::size_t i = 0;i<inlineCap;i++) {
+            dict["key"+std::to_string(i)] = int(i);
+        }
+
+        REQUIRE( dict.size() == inlineCap );
+        REQUIRE( dict.capacity() == inlineCap );
+        REQUIRE( dict.contains("key0") );
+        REQUIRE( !dict.contains("nokey") );
+        REQUIRE( dict["key3"] == 3 );
+
+        REQUIRE( dict.erase("key3") );
+        REQUIRE( !dict.contains("key3") );
+        dict["key3"] = 3;
+
+        int sum = 0;
+        for(const auto &it : dict) {
+            sum+= it.value;
+        }
+        REQUIRE( sum == int(inlineCap*(inlineCap-1)/2) );
+
+        // one entry past the inline capacity forces a
+        // spill to bucket storage; nothing gets lost
+        dict["key"+std::to_string(inlineCap)] = int(inlineCap);
+
+        REQUIRE( dict.size() == inlineCap+1 );
+        REQUIRE( dict.capacity()>inlineCap );
+        int err = 0;
+        for(std::size_t i = 0;i<=inlineCap;i++) {
+            if(dict["key"+std::to_string(i)] != int(i)) {
+                err++;
+            }
+        }
+        CHECK( err == 0 );
+    }
+
     SECTION("HashMapIterator Test") {
         HashMap<std::string, std::string> dict;
 
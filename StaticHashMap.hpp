@@ -0,0 +1,145 @@
+#ifndef STATIC_HASH_MAP
+#define STATIC_HASH_MAP
+
+#include "HashMap.hpp"
+
+/**
+ * @brief A perfect-hash map over a build-time key set
+ *
+ * For key sets fixed at compile time (opcode names,
+ * config field names) @HashMap still pays the full
+ * runtime hashing and probing cost. StaticHashMap
+ * instead searches a hash seed at compile time until
+ * every key lands in its own slot of a flat array,
+ * so a lookup is one hash, one multiply-shift and a
+ * single key compare — no chains, no probe loops.
+ *
+ * The whole table is a constexpr object: it can live
+ * in .rodata and costs nothing at startup. Values
+ * must be literal, default-constructible types.
+ *
+ * Usage:
+ *     static constexpr StaticEntry<int> opcodes[] = {
+ *         {"GET", 1}, {"PUT", 2}, {"DEL", 3},
+ *     };
+ *     static constexpr auto table =
+ *             makeStaticHashMap(opcodes);
+ *     table.find("PUT");
+ *
+ * If no collision-free seed exists for the key set
+ * (or a key is duplicated) the constexpr evaluation
+ * fails and the build breaks — misconfiguration is
+ * a compile error, never a runtime surprise.
+ */
+
+template <typename V>
+struct StaticEntry {
+    const char *key;
+    V value;
+};
+
+constexpr std::size_t staticStrEq(const char *a, const char *b) {
+    std::size_t i = 0;
+    for(;a[i] && b[i];i++) {
+        if(a[i] != b[i]) {
+            return false;
+        }
+    }
+    return a[i] == b[i];
+}
+
+// FNV-1a over the key bytes folded with a seeded
+// multiply-shift; the seed is what the compile-time
+// search varies until no two keys share a slot
+constexpr std::size_t staticHash(const char *s, std::uint64_t seed) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for(std::size_t i = 0;s[i];i++) {
+        h = (h ^ (unsigned char)s[i]) * 0x100000001b3ull;
+    }
+    return std::size_t((h*(seed|1)) >> 32);
+}
+
+constexpr std::size_t staticRoundUpPow2(std::size_t v) {
+    std::size_t r = 1;
+    while(r<v) {
+        r *= 2;
+    }
+    return r;
+}
+
+template <typename V, std::size_t N>
+class StaticHashMap {
+public:
+    // half-full table; keeps the seed search short
+    // while wasting at most 4x the entry storage
+    static constexpr std::size_t SLOT_COUNT = staticRoundUpPow2(2*N);
+
+    constexpr StaticHashMap(const StaticEntry<V> (&entries)[N]):
+                                        m_seed(0),
+                                        m_slots{}
+    {
+        for(std::uint64_t seed = 1;seed<100000;seed++) {
+            if(tryPlace(entries, seed)) {
+                m_seed = seed;
+                return;
+            }
+        }
+        // evaluated at compile time, so this fails
+        // the build rather than throwing at runtime
+        throw "StaticHashMap: no collision-free seed for this key set";
+    }
+
+    constexpr const V *find(const char *k) const {
+        const StaticEntry<V> &s =
+                m_slots[staticHash(k, m_seed)&(SLOT_COUNT-1)];
+        return (s.key && staticStrEq(s.key, k)) ? &s.value : nullptr;
+    }
+
+    const V *find(const std::string &k) const {
+        return find(k.c_str());
+    }
+
+    constexpr bool contains(const char *k) const {
+        return find(k) != nullptr;
+    }
+
+    constexpr std::size_t size() const {
+        return N;
+    }
+
+    constexpr std::size_t capacity() const {
+        return SLOT_COUNT;
+    }
+
+private:
+    constexpr bool tryPlace(const StaticEntry<V> (&entries)[N],
+                            std::uint64_t seed) {
+        for(std::size_t i = 0;i<SLOT_COUNT;i++) {
+            m_slots[i].key = nullptr;
+            m_slots[i].value = V();
+        }
+        for(std::size_t i = 0;i<N;i++) {
+            std::size_t slot = staticHash(entries[i].key, seed)&
+                    (SLOT_COUNT-1);
+            if(m_slots[slot].key) {
+                return false;
+            }
+            m_slots[slot].key = entries[i].key;
+            m_slots[slot].value = entries[i].value;
+        }
+        return true;
+    }
+
+private:
+    std::uint64_t m_seed;
+    StaticEntry<V> m_slots[SLOT_COUNT];
+};
+
+// deduces value type and key count from the array
+template <typename V, std::size_t N>
+constexpr StaticHashMap<V, N> makeStaticHashMap(
+        const StaticEntry<V> (&entries)[N]) {
+    return StaticHashMap<V, N>(entries);
+}
+
+#endif // STATIC_HASH_MAP